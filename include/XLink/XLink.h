@@ -95,6 +95,14 @@ XLinkError_t XLinkSearchForDevices(const deviceDesc_t in_deviceRequirements,
  */
 XLinkError_t XLinkConnect(XLinkHandler_t* handler);
 
+/**
+ * @brief Connects like XLinkConnect, sizing the stream packet queues and dispatcher event queues of the link
+ * @param[in,out] handler - XLink communication parameters (file path name for underlying layer)
+ * @param[in] limits - capacity of the link, NULL for the defaults
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkConnectWithLimits(XLinkHandler_t* handler, const XLinkLinkLimits_t* limits);
+
 /**
  * @brief Puts device into bootloader mode
  * @param deviceDesc - device description structure, obtained from XLinkFind* functions call
@@ -201,6 +209,55 @@ XLinkError_t XLinkProfPrint();
 XLinkError_t XLinkGetGlobalProfilingData(XLinkProf_t* prof);
 XLinkError_t XLinkGetProfilingData(linkId_t id, XLinkProf_t* prof);
 
+/**
+ * @brief Coalesces packet releases of the link's streams into one release event per stream,
+ *  sent once maxPackets releases are pending or the oldest one waited maxDelayMs.
+ *  Saves a release request and response on the wire per packet.
+ * @warning The remote must announce XLINK_FEATURE_RELEASE_COALESCING in its capabilities,
+ *  see XLinkGetPeerCapabilities. Fails otherwise, also for a remote announcing no capabilities (version 0)
+ * @param[in] id - link Id obtained from XLinkConnect in the handler parameter
+ * @param[in] maxPackets - releases sent together, at most XLINK_MAX_PACKETS_PER_STREAM. 0 or 1 disables coalescing
+ * @param[in] maxDelayMs - longest time a release is held back
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkSetReleaseCoalescing(linkId_t id, uint32_t maxPackets, unsigned int maxDelayMs);
+
+/**
+ * @brief Returns what the remote announced while connecting: its feature bitmap and limits
+ * @param[in] id - link Id obtained from XLinkConnect in the handler parameter
+ * @param[out] caps - the remote's capabilities, all 0 if the remote doesn't take part in the handshake
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetPeerCapabilities(linkId_t id, XLinkCapabilities_t* caps);
+
+/**
+ * @brief Reads TCP/IP links connected afterwards with count shared threads, each waiting on
+ *  many links with epoll, instead of a reader thread per link. Other links are unaffected.
+ * @note Linux only. Must be called while no link uses the shared threads.
+ * @param[in] count - number of shared reader threads, at most 16. 0 (default) disables them
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkSetTcpReactorThreads(unsigned int count);
+
+/**
+ * @brief Schedules links connected afterwards on count shared worker threads instead of a
+ *  scheduler thread per link, so connecting or disconnecting a link creates no threads once warm.
+ * @note Must be called while no link uses the shared workers.
+ * @param[in] count - number of shared worker threads, at most 16. 0 (default) disables them
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkSetSchedulerThreads(unsigned int count);
+
+/**
+ * @brief Writes the latest dispatcher events of the link to a file in Chrome trace event
+ *  format, for Perfetto or chrome://tracing. Each event is traced from being added, through
+ *  the scheduler and the link writes, to being served; tracing is always on.
+ * @param[in] id - link Id obtained from XLinkConnect in the handler parameter
+ * @param[in] path - file to write, replaced if it exists
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkTraceDump(linkId_t id, const char* path);
+
 
 // ------------------------------------
 // Device management. End.
@@ -252,6 +309,21 @@ XLinkError_t XLinkWriteData(streamId_t const streamId, const uint8_t* buffer, in
  */
 XLinkError_t XLinkWriteDataWithTimeout(streamId_t const streamId, const uint8_t* buffer, int size, unsigned int msTimeout);
 
+/**
+ * @brief Queues data for sending to the remote without waiting, writes to a stream keep their order.
+ *  The write is sent once the remote has space for it, callback tells when it completed.
+ * @param[in] streamId – stream link Id obtained from XLinkOpenStream call
+ * @param[in] buffer – data buffer to be transmitted, must stay valid until callback is called
+ * @param[in] size – size of the data to be transmitted
+ * @param[in] callback – called once the remote accepted the data or the write failed
+ * @param[in] userData – passed to callback
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success,
+ *  X_LINK_OUT_OF_MEMORY while half the link's eventsPerQueue writes are in flight, or half the remote's
+ *  if it announced fewer; retry once one completes
+ */
+XLinkError_t XLinkWriteDataAsync(streamId_t const streamId, const uint8_t* buffer, int size,
+                                 XLinkWriteCallback_t callback, void* userData);
+
 /**
  * @brief Reads data from local stream. Will only have something if it was written to by the remote
  * @param[in]   streamId - stream link Id obtained from XLinkOpenStream call
@@ -269,6 +341,20 @@ XLinkError_t XLinkReadData(streamId_t const streamId, streamPacketDesc_t** packe
  */
 XLinkError_t XLinkReadDataWithTimeout(streamId_t const streamId, streamPacketDesc_t** packet, unsigned int msTimeout);
 
+/**
+ * @brief Reads up to maxCount packets already queued on the local stream in a single dispatcher pass.
+ *  Blocks only while the stream holds no packet.
+ * @note Every returned packet must be released, e.g. with a single XLinkReleaseDataBatch(streamId, count) call
+ * @param[in]   streamId - stream link Id obtained from XLinkOpenStream call
+ * @param[out]  packets - array of at least maxCount packet pointers, filled with count packets in arrival order
+ * @param[in]   maxCount - maximum number of packets to read, capped at XLINK_MAX_PACKETS_PER_STREAM
+ * @param[out]  count - number of packets read
+ * @param[in]   timeoutMs - time in milliseconds after which operation times out, XLINK_NO_RW_TIMEOUT to wait indefinitely
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success, X_LINK_TIMEOUT when timeoutMs time passes
+ */
+XLinkError_t XLinkReadDataBatch(streamId_t const streamId, streamPacketDesc_t** packets,
+                                uint32_t maxCount, uint32_t* count, unsigned int timeoutMs);
+
 /**
  * @brief Releases specific data from stream
  * @param[in] streamId – stream link Id obtained from XLinkOpenStream call
@@ -311,6 +397,47 @@ void XLinkDeallocateMoveData(void* const data, const uint32_t length);
  */
 XLinkError_t XLinkReleaseData(streamId_t const streamId);
 
+/**
+ * @brief Releases the count oldest packets of the stream with a single request to the dispatcher
+ * @param[in] streamId - stream link Id obtained from XLinkOpenStream call
+ * @param[in] count - number of packets to release, at most XLINK_MAX_PACKETS_PER_STREAM
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkReleaseDataBatch(streamId_t const streamId, uint32_t count);
+
+/**
+ * @brief Registers caller owned buffers the stream receives data into, avoiding an allocation per packet.
+ *  XLinkReadData then returns packets pointing into these buffers; a buffer is reused once its packet is released.
+ *  Packets bigger than size, or arriving while all buffers are in use, fall back to internal allocation.
+ * @note Buffers stay owned by the caller and must outlive the stream or a later unregistration (count = 0).
+ *  Move reads (XLinkReadMoveData) from such buffers return a copy.
+ * @param[in] streamId - stream link Id obtained from XLinkOpenStream call
+ * @param[in] buffers - array of count buffers, each at least size bytes
+ * @param[in] count - number of buffers, at most XLINK_MAX_PACKETS_PER_STREAM
+ * @param[in] size - size of each buffer in bytes
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success,
+ *  X_LINK_ERROR if previously registered buffers still hold unreleased packets
+ */
+XLinkError_t XLinkRegisterReadBuffers(streamId_t const streamId, void* const* buffers, uint32_t count, uint32_t size);
+
+/**
+ * @brief Returns usage counters of the stream packet buffer pool
+ * @param[in]   streamId - stream link Id obtained from XLinkOpenStream call
+ * @param[out]  stats - pool hit/miss counters and current pool size
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetBufferPoolStats(streamId_t const streamId, XLinkBufferPoolStats_t* stats);
+
+/**
+ * @brief Returns traffic counters, fill levels and latency histograms of a stream.
+ *  Reads them without locking, so it doesn't wait on a stream which is backed up.
+ * @param[in]   streamId - stream link Id obtained from XLinkOpenStream call
+ * @param[out]  stats - counters since the stream was opened, see XLINK_STATS_BUCKET_LOWER_US
+ *  for the histogram buckets
+ * @return Status code of the operation: X_LINK_SUCCESS (0) for success
+ */
+XLinkError_t XLinkGetStreamStats(streamId_t const streamId, XLinkStreamStats_t* stats);
+
 /**
  * @brief Reads data from local stream with timeout in ms. Will only have something if it was written to by the remote.
  * Limitations.
@@ -0,0 +1,102 @@
+///
+/// @file
+///
+/// @brief     Minimal sequentially consistent atomic operations on 32-bit values,
+///            and counters on 64-bit ones
+///
+#ifndef _XLINK_ATOMIC_H
+#define _XLINK_ATOMIC_H
+
+#include <stdint.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+
+static __inline uint32_t XLink_atomic_load(volatile uint32_t* ptr) {
+    return (uint32_t)_InterlockedCompareExchange((volatile long*)ptr, 0, 0);
+}
+
+static __inline void XLink_atomic_store(volatile uint32_t* ptr, uint32_t value) {
+    _InterlockedExchange((volatile long*)ptr, (long)value);
+}
+
+static __inline uint32_t XLink_atomic_exchange(volatile uint32_t* ptr, uint32_t value) {
+    return (uint32_t)_InterlockedExchange((volatile long*)ptr, (long)value);
+}
+
+static __inline uint32_t XLink_atomic_fetch_add(volatile uint32_t* ptr, uint32_t value) {
+    return (uint32_t)_InterlockedExchangeAdd((volatile long*)ptr, (long)value);
+}
+
+// On failure stores the current value into expected
+static __inline int XLink_atomic_compare_exchange(volatile uint32_t* ptr, uint32_t* expected, uint32_t desired) {
+    long prev = _InterlockedCompareExchange((volatile long*)ptr, (long)desired, (long)*expected);
+    if ((uint32_t)prev == *expected) {
+        return 1;
+    }
+    *expected = (uint32_t)prev;
+    return 0;
+}
+
+static __inline uint64_t XLink_atomic_load_64(volatile uint64_t* ptr) {
+    return (uint64_t)_InterlockedCompareExchange64((volatile __int64*)ptr, 0, 0);
+}
+
+// Compare exchange loop, 32-bit targets have no 64-bit exchange add
+static __inline uint64_t XLink_atomic_fetch_add_64(volatile uint64_t* ptr, uint64_t value) {
+    __int64 prev = *(volatile __int64*)ptr;
+    for (;;) {
+        __int64 seen = _InterlockedCompareExchange64((volatile __int64*)ptr, prev + (__int64)value, prev);
+        if (seen == prev) {
+            return (uint64_t)prev;
+        }
+        prev = seen;
+    }
+}
+
+#else
+
+static inline uint32_t XLink_atomic_load(volatile uint32_t* ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+static inline void XLink_atomic_store(volatile uint32_t* ptr, uint32_t value) {
+    __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t XLink_atomic_exchange(volatile uint32_t* ptr, uint32_t value) {
+    return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t XLink_atomic_fetch_add(volatile uint32_t* ptr, uint32_t value) {
+    return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+// On failure stores the current value into expected
+static inline int XLink_atomic_compare_exchange(volatile uint32_t* ptr, uint32_t* expected, uint32_t desired) {
+    return __atomic_compare_exchange_n(ptr, expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline uint64_t XLink_atomic_load_64(volatile uint64_t* ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+static inline uint64_t XLink_atomic_fetch_add_64(volatile uint64_t* ptr, uint64_t value) {
+    return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _XLINK_ATOMIC_H
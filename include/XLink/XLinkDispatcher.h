@@ -19,6 +19,26 @@ extern "C"
 #endif
 typedef int (*getRespFunction) (xLinkEvent_t*,
                 xLinkEvent_t*);
+
+/**
+ * @brief Progress of an event received piecewise, as data shows up on the link
+ */
+typedef struct {
+    uint32_t headerBytes;
+    uint32_t dataBytes;
+    void* data;
+    void* stream; // stream the payload goes to, held until the event completes
+    XLinkTimespec treceive;
+    uint32_t pendingBytes; // read ahead off the link, its descriptor doesn't signal them anymore
+} xLinkEventReceiveState_t;
+
+typedef enum {
+    XLINK_RECEIVE_FAILED = -2,  // the link can't be read anymore
+    XLINK_RECEIVE_DROPPED = -1, // the event couldn't be handled and was dropped
+    XLINK_RECEIVE_INCOMPLETE = 0,
+    XLINK_RECEIVE_COMPLETE = 1,
+} xLinkReceiveResult_t;
+
 typedef struct {
     int (*eventSend) (xLinkEvent_t*);
     int (*eventReceive) (xLinkEvent_t*);
@@ -26,16 +46,56 @@ typedef struct {
     getRespFunction remoteGetResponse;
     void (*closeLink) (void* fd, int fullClose);
     void (*closeDeviceFd) (xLinkDeviceHandle_t* deviceHandle);
+    // Optional. Sends work deferred by the handlers, returns ms until the next is due
+    // or XLINK_NO_RW_TIMEOUT if nothing is deferred
+    unsigned int (*flushDeferred) (xLinkDeviceHandle_t* deviceHandle);
+    // Optional. Writes the events eventSend held back to batch them, called before going idle
+    int (*flushSends) (xLinkDeviceHandle_t* deviceHandle);
+    // Optional. Continues receiving an event without blocking, returns xLinkReceiveResult_t
+    int (*eventReceivePartial) (xLinkEvent_t*, xLinkEventReceiveState_t*);
+    // Optional. Drops an event received partially
+    void (*eventReceiveCancel) (xLinkEvent_t*, xLinkEventReceiveState_t*);
 } DispatcherControlFunctions;
 
+/**
+ * @brief Signalled when a local event is served. Owned by the API call
+ *        waiting for the event, usually on its stack.
+ */
+typedef struct {
+    XLink_sem_t sem;
+} xLinkEventCompletion_t;
+
+/**
+ * @brief Called instead of signalling a completion once an asynchronous local event is served
+ */
+typedef void (*xLinkEventCallback_t)(xLinkEvent_t* event);
+
+#define XLINK_MAX_SCHEDULER_THREADS 16
+
 XLinkError_t DispatcherInitialize(DispatcherControlFunctions *controlFunc);
+// Links started afterwards are scheduled by count shared worker threads,
+// 0 (default) gives each link scheduler threads of its own
+XLinkError_t DispatcherSetSchedulerThreads(unsigned int count);
 XLinkError_t DispatcherStart(xLinkDeviceHandle_t *deviceHandle);
 int DispatcherClean(xLinkDeviceHandle_t *deviceHandle);
 int DispatcherDeviceFdDown(xLinkDeviceHandle_t *deviceHandle);
 
-xLinkEvent_t* DispatcherAddEvent(xLinkEventOrigin_t origin, xLinkEvent_t *event);
-int DispatcherWaitEventComplete(xLinkDeviceHandle_t *deviceHandle, unsigned int timeoutMs);
-int DispatcherWaitEventCompleteTimeout(xLinkDeviceHandle_t *deviceHandle, struct timespec abstime);
+// Local events need a completion, which is initialized here and
+// released by DispatcherWaitEventComplete*() once the event is added
+xLinkEvent_t* DispatcherAddEvent(xLinkEventOrigin_t origin, xLinkEvent_t *event,
+                                 xLinkEventCompletion_t* completion);
+// Adds a local event nobody waits for, the event is copied and may go out of scope
+xLinkEvent_t* DispatcherAddEventAsync(xLinkEvent_t *event, xLinkEventCallback_t callback);
+int DispatcherWaitEventComplete(xLinkDeviceHandle_t *deviceHandle,
+                                xLinkEventCompletion_t* completion, unsigned int timeoutMs);
+// Returns X_LINK_TIMEOUT once timeoutMs passed, without resetting the link
+int DispatcherWaitEventCompleteTimeout(xLinkDeviceHandle_t *deviceHandle,
+                                       xLinkEventCompletion_t* completion, unsigned int timeoutMs);
+// Like DispatcherWaitEventCompleteTimeout, but drops the event when giving up. An event the
+// scheduler is processing is served instead of blocked, returning X_LINK_TIMEOUT if it would block
+int DispatcherWaitEventCompleteOrWithdraw(xLinkDeviceHandle_t *deviceHandle,
+                                          xLinkEventCompletion_t* completion,
+                                          unsigned int timeoutMs, const xLinkEvent_t* event);
 
 char* TypeToStr(int type);
 int DispatcherUnblockEvent(eventId_t id,
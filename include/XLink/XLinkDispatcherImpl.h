@@ -6,14 +6,19 @@
 #define _XLINKDISPATCHERIMPL_H
 
 #include "XLinkPrivateDefines.h"
+#include "XLinkDispatcher.h"
 
 int dispatcherEventSend (xLinkEvent_t*);
 int dispatcherEventReceive (xLinkEvent_t*);
+int dispatcherEventReceivePartial (xLinkEvent_t*, xLinkEventReceiveState_t*);
+void dispatcherEventReceiveCancel (xLinkEvent_t*, xLinkEventReceiveState_t*);
 int dispatcherLocalEventGetResponse (xLinkEvent_t*,
                         xLinkEvent_t*);
 int dispatcherRemoteEventGetResponse (xLinkEvent_t*,
                         xLinkEvent_t*);
 void dispatcherCloseLink (void* fd, int fullClose);
 void dispatcherCloseDeviceFd (xLinkDeviceHandle_t* deviceHandle);
+unsigned int dispatcherFlushDeferred (xLinkDeviceHandle_t* deviceHandle);
+int dispatcherFlushSends (xLinkDeviceHandle_t* deviceHandle);
 
 #endif //_XLINKDISPATCHERIMPL_H
@@ -18,6 +18,9 @@
  * Setting log level through debugger can be done in the following way:
  * mset mvLogLevel_unitname 2
  * Will set log level to warnings and above
+ *
+ * Levels below MVLOG_MIN_LEVEL are compiled out. The level is checked before
+ * the arguments of mvLog are evaluated, disabled messages cost a comparison.
  */
 #ifndef MVLOG_H__
 #define MVLOG_H__
@@ -73,14 +76,41 @@ FUNCATTR_WEAK mvLog_t __attribute__ ((weak)) MVLOGLEVEL(MVLOG_UNIT_NAME) = MVLOG
 
 #define UNIT_NAME_STR MVLOG_STR(MVLOG_UNIT_NAME)
 
+#ifndef MVLOG_MIN_LEVEL
+#define MVLOG_MIN_LEVEL MVLOG_DEBUG
+#endif
+
+#ifndef MVLOG_ASYNC_RING_SIZE
+#define MVLOG_ASYNC_RING_SIZE 256 // messages queued for the log thread, a power of two
+#endif
+
+#ifndef MVLOG_ASYNC_MESSAGE_SIZE
+#define MVLOG_ASYNC_MESSAGE_SIZE 256 // longer queued messages are truncated
+#endif
+
 
 extern XLINK_EXPORT mvLog_t MVLOGLEVEL(global);
 extern XLINK_EXPORT mvLog_t MVLOGLEVEL(default);
 
 int __attribute__ ((unused)) logprintf(mvLog_t curLogLvl, mvLog_t lvl, const char * func, const int line, const char * format, ...);
 
-#define mvLog(lvl, format, ...)                              \
-    logprintf(MVLOGLEVEL(MVLOG_UNIT_NAME), lvl, __func__, __LINE__, format, ##__VA_ARGS__)
+static inline int mvLogLevelEnabled(mvLog_t unitLvl, mvLog_t lvl){
+    if(unitLvl == MVLOG_LAST){
+        return lvl >= MVLOGLEVEL(default);
+    }
+    return lvl >= unitLvl;
+}
+
+#define mvLog(lvl, format, ...)                                                             \
+    (((lvl) >= MVLOG_MIN_LEVEL && mvLogLevelEnabled(MVLOGLEVEL(MVLOG_UNIT_NAME), (lvl))) ?  \
+        logprintf(MVLOGLEVEL(MVLOG_UNIT_NAME), lvl, __func__, __LINE__, format, ##__VA_ARGS__) : 0)
+
+/**
+ * Hands messages to a background thread which writes them out. Callers only format
+ * the message into a lock-free ring, messages are dropped while the ring is full.
+ * Disabling writes out the queued messages. Returns 0 on success
+ */
+XLINK_EXPORT int mvLogSetAsync(int enable);
 
 // Set log level for the current unit. Note that the level must be smaller than the global default
 static inline void mvLogLevelSet(mvLog_t lvl){
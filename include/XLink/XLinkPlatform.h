@@ -22,6 +22,7 @@ extern "C"
 #define MAX_POOLS_ALLOC 32
 #endif
 #define PACKET_LENGTH (64*1024)
+#define XLINK_PLATFORM_MAX_IOV 16
 
 typedef enum {
     X_LINK_PLATFORM_SUCCESS = 0,
@@ -83,10 +84,56 @@ xLinkPlatformErrorCode_t XLinkPlatformCloseRemote(xLinkDeviceHandle_t* deviceHan
 // Data management. Begin.
 // ------------------------------------
 
+/**
+ * @brief Single buffer of a vectored (scatter-gather) write
+ */
+typedef struct xLinkPlatformIoVec_t {
+    void* data;
+    int size;
+} xLinkPlatformIoVec_t;
+
 int XLinkPlatformWrite(xLinkDeviceHandle_t *deviceHandle, void *data, int size);
+/**
+ * @brief Writes all given buffers back to back, in order
+ * @note Stream transports (TCP/IP) send the buffers with a single vectored call.
+ *       Message based transports (USB, PCIe) keep one transfer per buffer,
+ *       as transfer boundaries are part of the protocol with the remote.
+ */
+int XLinkPlatformWritev(xLinkDeviceHandle_t *deviceHandle, const xLinkPlatformIoVec_t *iov, int iovcnt);
+/**
+ * @brief Writes each buffer as a transfer the remote reads whole with XLinkPlatformReadAtLeast,
+ *        so that one transfer can carry several events
+ * @note Same as XLinkPlatformWritev where the transport has no such transfers
+ */
+int XLinkPlatformWriteTransfers(xLinkDeviceHandle_t *deviceHandle, const xLinkPlatformIoVec_t *iov, int iovcnt);
 int XLinkPlatformRead(xLinkDeviceHandle_t *deviceHandle, void *data, int size);
+/**
+ * @brief Reads the data already received, up to size bytes, without blocking
+ * @return Number of bytes read, 0 if nothing is pending,
+ *         negative on error or when the remote closed the connection
+ * @note Only stream transports (TCP/IP) support this, see XLinkPlatformGetPollFd
+ */
+int XLinkPlatformReadNonBlocking(xLinkDeviceHandle_t *deviceHandle, void *data, int size);
+/**
+ * @brief Reads at least size bytes, and what else was received meanwhile up to capacity
+ * @return Number of bytes read, negative on error
+ * @note USB reads whole transfers until it has size bytes, other message based
+ *       transports read exactly size bytes
+ */
+int XLinkPlatformReadAtLeast(xLinkDeviceHandle_t *deviceHandle, void *data, int size, int capacity);
+/**
+ * @brief Returns a descriptor which becomes readable when data arrives on the link,
+ *        -1 if the transport has none
+ */
+int XLinkPlatformGetPollFd(xLinkDeviceHandle_t *deviceHandle);
 
 void* XLinkPlatformAllocateData(uint32_t size, uint32_t alignment);
+/**
+ * @brief Allocates a buffer to receive data of the given link into. Where the transport
+ *        supports it (usbfs on Linux) the buffer is DMA memory, read into without a kernel copy.
+ *        Otherwise the same as XLinkPlatformAllocateData. Freed with XLinkPlatformDeallocateData.
+ */
+void* XLinkPlatformAllocateDeviceData(xLinkDeviceHandle_t *deviceHandle, uint32_t size, uint32_t alignment);
 void XLinkPlatformDeallocateData(void *ptr, uint32_t size, uint32_t alignment);
 
 // ------------------------------------
@@ -11,6 +11,7 @@
 #define _XLINKPRIVATEDEFINES_H
 
 #include "XLinkStream.h"
+#include "XLinkTrace.h"
 #include "XLinkPublicDefines.h"
 
 #if !defined(XLINK_ALIGN_TO_BOUNDARY)
@@ -26,11 +27,6 @@ extern "C"
 {
 #endif
 
-#ifdef XLINK_MAX_STREAM_RES
-#define MAXIMUM_SEMAPHORES XLINK_MAX_STREAM_RES
-#else
-#define MAXIMUM_SEMAPHORES 32
-#endif
 #define __CACHE_LINE_SIZE 64
 
 typedef int32_t eventId_t;
@@ -73,6 +69,37 @@ typedef struct xLinkDesc_t {
     // profiling
     XLinkProf_t profilingData;
 
+    // Coalesced releases, see XLinkSetReleaseCoalescing. Disabled below 2 packets
+    uint32_t releaseCoalescePackets;
+    uint32_t releaseCoalesceDelayMs;
+
+    // XLinkWriteDataAsync calls not completed yet
+    volatile uint32_t asyncWrites;
+
+    // Capacity, see XLinkConnectWithLimits
+    uint32_t packetsPerStream;
+    uint32_t eventsPerQueue;
+
+    // Compact headers, once both announced XLINK_FEATURE_COMPACT_HEADER in the connect ping
+    volatile uint32_t compactHeaderRx; // set by the reader, the remote sends them from its next event on
+    volatile uint32_t compactHeaderTx; // set by the scheduler, before the next event is sent
+
+    // Announced by the remote in the connect ping, see XLinkHandshakeRead
+    XLinkCapabilities_t peer;
+
+    // Events written by the scheduler, not handed to the transport yet. Stream transports,
+    // and USB once the remote announced XLINK_FEATURE_BATCHED_EVENTS
+    struct xLinkSendBatch_t* sendBatch;
+    // Bytes read ahead of the events received so far, used by the link's reader. Same transports
+    struct xLinkRecvBuffer_t* recvBuffer;
+
+    // Dispatcher events of the link, see XLinkTraceDump
+    xLinkTraceRing_t trace;
+
+    // Lookup hints, checked against the slot before use
+    volatile uint32_t streamIndexHints[XLINK_MAX_STREAMS]; // by stream id modulo XLINK_MAX_STREAMS
+    volatile uint32_t schedulerIndexHint;                  // set by DispatcherStart
+
 } xLinkDesc_t;
 
 streamId_t XLinkAddOrUpdateStream(void *fd, const char *name,
@@ -126,10 +153,31 @@ typedef enum
 #define MAX_LINKS 1
 #endif
 
-#define MAX_EVENTS 64
+#define MAX_EVENTS XLINK_DEFAULT_EVENTS_PER_QUEUE
 #define MAX_SCHEDULERS MAX_LINKS
 #define XLINK_MAX_DEVICES MAX_LINKS
 
+// Events the scheduler writes to a link with one call, 1 writes each on its own
+#ifndef XLINK_SEND_BATCH_EVENTS
+#define XLINK_SEND_BATCH_EVENTS 16
+#endif
+// Bytes copied into a batch before it is written. Larger parts are written from their buffer
+#ifndef XLINK_SEND_BATCH_BYTES
+#define XLINK_SEND_BATCH_BYTES (64 * 1024)
+#endif
+#ifndef XLINK_SEND_BATCH_COPY_SIZE
+#define XLINK_SEND_BATCH_COPY_SIZE 1024
+#endif
+
+// Bytes a link reads ahead, to take several events off it per read
+#ifndef XLINK_RECV_BUFFER_BYTES
+#define XLINK_RECV_BUFFER_BYTES (64 * 1024)
+#endif
+// Payloads from this size on are read into their packet directly
+#ifndef XLINK_RECV_DIRECT_SIZE
+#define XLINK_RECV_DIRECT_SIZE 4096
+#endif
+
 typedef struct xLinkEventHeader_t{
     eventId_t           id;
     xLinkEventType_t    type;
@@ -151,14 +199,43 @@ typedef struct xLinkEventHeader_t{
             uint32_t sizeTooBig : 1;
             uint32_t noSuchStream : 1;
             uint32_t moveSemantic : 1;
+            uint32_t releaseCount : 8; // packets released by a coalesced XLINK_READ_REL_REQ, 0 - single release
+            uint32_t handshake : 1;     // XLINK_PING_REQ/RESP: streamName carries the sender's XLinkCapabilities_t
         }bitField;
     }flags;
 }xLinkEventHeader_t;
 
+#define XLINK_COMPACT_HEADER_MARK 0x80000000u // never set in the id starting a full header
+#define XLINK_COMPACT_HEADER_TYPE_SHIFT 24
+#define XLINK_COMPACT_HEADER_FLAGS_MASK 0x00FFFFFFu
+
+/**
+ * @brief Header of data path events (write, release and their responses) once both
+ *        peers agreed on it. Other events keep xLinkEventHeader_t, written in two parts
+ *        so the receiver can read sizeof(xLinkCompactEventHeader_t) first and tell them apart
+ */
+typedef struct xLinkCompactEventHeader_t{
+    uint32_t            typeFlags;  // XLINK_COMPACT_HEADER_MARK | type << XLINK_COMPACT_HEADER_TYPE_SHIFT | flags.raw
+    eventId_t           id;
+    streamId_t          streamId;
+    uint32_t            size;
+    uint64_t            timeNs;     // tsecMsb, tsecLsb and tnsec in nanoseconds
+}xLinkCompactEventHeader_t;
+
+/**
+ * @brief Writes the link's capabilities into a ping header, reads the remote's out of one
+ */
+void XLinkHandshakeWrite(const xLinkDesc_t* link, xLinkEventHeader_t* header);
+void XLinkHandshakeRead(xLinkDesc_t* link, const xLinkEventHeader_t* header);
+uint32_t XLinkHandshakeFeatures(const xLinkEventHeader_t* header);
+
 typedef struct xLinkEvent_t {
     XLINK_ALIGN_TO_BOUNDARY(64) xLinkEventHeader_t header;
     xLinkDeviceHandle_t deviceHandle;
     void* data;
+    uint32_t packetCount;   // packets of a batched local READ_REQ/READ_REL_REQ, 0 for a single packet
+    XLinkWriteCallback_t writeCallback; // completion of an asynchronous write, see XLinkWriteDataAsync
+    void* writeCallbackData;
 }xLinkEvent_t;
 
 #define XLINK_INIT_EVENT(event, in_streamId, in_type, in_size, in_data, in_deviceHandle) do { \
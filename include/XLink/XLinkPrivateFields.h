@@ -47,6 +47,11 @@ streamId_t getStreamIdByName(xLinkDesc_t* link, const char* name);
 
 streamDesc_t* getStreamById(void* fd, streamId_t id);
 streamDesc_t* getStreamByName(xLinkDesc_t* link, const char* name);
+/**
+ * @brief Finds the stream without taking it. Only for lock free access, the
+ *        descriptor may be closed and reused meanwhile.
+ */
+streamDesc_t* peekStreamById(void* fd, streamId_t id);
 
 void releaseStream(streamDesc_t* stream);
 
@@ -0,0 +1,45 @@
+///
+/// @file
+///
+/// @brief     USDT tracepoints of provider "xlink", compiled in with XLINK_ENABLE_USDT.
+///            A probe is a nop until a tracer attaches, e.g.
+///            bpftrace -e 'usdt:libXLink.so:xlink:event_enqueue { @[arg3] = count(); }'
+///
+///            link_up              (linkId, handle, protocol)
+///            link_down            (linkId, handle)
+///            stream_open          (linkId, streamId, writeSize)
+///            stream_close         (linkId, streamId)
+///            event_enqueue        (linkId, streamId, eventId, type, size)
+///            event_dequeue        (linkId, streamId, eventId, type, size)
+///            platform_write_begin (handle, size)
+///            platform_write_end   (handle, size, rc)
+///            platform_read_begin  (handle, size)
+///            platform_read_end    (handle, size, rc)
+///            packet_alloc         (streamId, size, data)
+///            packet_free          (streamId, size, data)
+///
+///            Transport probes identify the link by its handle, link_up maps it to the link id.
+///
+#ifndef _XLINKPROBES_H
+#define _XLINKPROBES_H
+
+#ifdef XLINK_ENABLE_USDT
+
+#include <sys/sdt.h>
+
+#define XLINK_PROBE2(name, a1, a2) DTRACE_PROBE2(xlink, name, a1, a2)
+#define XLINK_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(xlink, name, a1, a2, a3)
+#define XLINK_PROBE4(name, a1, a2, a3, a4) DTRACE_PROBE4(xlink, name, a1, a2, a3, a4)
+#define XLINK_PROBE5(name, a1, a2, a3, a4, a5) DTRACE_PROBE5(xlink, name, a1, a2, a3, a4, a5)
+
+#else
+
+// arguments are not evaluated
+#define XLINK_PROBE2(name, a1, a2) do {} while (0)
+#define XLINK_PROBE3(name, a1, a2, a3) do {} while (0)
+#define XLINK_PROBE4(name, a1, a2, a3, a4) do {} while (0)
+#define XLINK_PROBE5(name, a1, a2, a3, a4, a5) do {} while (0)
+
+#endif  // XLINK_ENABLE_USDT
+
+#endif  // _XLINKPROBES_H
@@ -25,7 +25,8 @@ extern "C"
 #else
 #define XLINK_MAX_STREAMS 32
 #endif
-#define XLINK_MAX_PACKETS_PER_STREAM 64
+#define XLINK_MAX_PACKETS_PER_STREAM 64 // default stream depth, and most packets a single call handles
+#define XLINK_DEFAULT_EVENTS_PER_QUEUE 64
 #define XLINK_NO_RW_TIMEOUT 0xFFFFFFFF
 
 
@@ -141,6 +142,47 @@ typedef struct XLinkProf_t
     float totalBootTime;
 } XLinkProf_t;
 
+typedef struct XLinkBufferPoolStats_t
+{
+    uint64_t hits;          /// packet buffers reused from the stream pool
+    uint64_t misses;        /// packet buffers taken from the system allocator
+    uint32_t cachedBuffers; /// buffers currently kept in the pool
+    uint32_t cachedBytes;   /// bytes currently kept in the pool
+} XLinkBufferPoolStats_t;
+
+#define XLINK_STATS_LATENCY_BUCKETS 100
+/**
+ * @brief Lower bound in microseconds of a latency histogram bucket. Values below 4us
+ *  have a bucket each, above that every power of two is split into 4 buckets.
+ *  The last bucket also counts all larger values.
+ */
+#define XLINK_STATS_BUCKET_LOWER_US(bucket) \
+    ((bucket) < 4 ? (uint64_t)(bucket) : (uint64_t)(4 + ((bucket) & 3)) << (((bucket) >> 2) - 1))
+
+typedef struct XLinkStreamStats_t
+{
+    uint64_t packetsOut;      /// packets written to the remote
+    uint64_t bytesOut;
+    uint64_t packetsIn;       /// packets received from the remote
+    uint64_t bytesIn;
+    uint64_t drops;           /// received packets dropped for lack of room or memory
+    uint64_t nacks;           /// writes refused locally or by the remote
+    uint32_t localFillLevel;  /// received bytes not released yet
+    uint32_t remoteFillLevel; /// written bytes not released by the remote yet
+    uint64_t blockedWriteUs;  /// time writes waited for space on the remote
+    uint64_t blockedReadUs;   /// time reads found the stream empty until data arrived
+    uint32_t callLatency[XLINK_STATS_LATENCY_BUCKETS];    /// duration of read and write calls
+    uint32_t transitLatency[XLINK_STATS_LATENCY_BUCKETS]; /// tReceived - tRemoteSent of received packets
+} XLinkStreamStats_t;
+
+/**
+ * @brief Completion of XLinkWriteDataAsync, called once the remote accepted the data or the write failed
+ * @note Runs on a thread serving the link, outside of its locks. It may call XLink functions which
+ *  don't wait for the link, as XLinkWriteDataAsync or XLinkGetStreamStats, but blocking ones as
+ *  XLinkWriteData or XLinkReadData would wait for the thread running it
+ */
+typedef void (*XLinkWriteCallback_t)(const uint8_t* buffer, int size, XLinkError_t status, void* userData);
+
 typedef struct XLinkGlobalHandler_t
 {
     int profEnable;
@@ -161,6 +203,38 @@ typedef struct
     XLinkProtocol_t protocol;
 } XLinkHandler_t;
 
+/**
+ * @brief Capacity limits of a link, see XLinkConnectWithLimits. Fields left 0 take the default
+ */
+typedef struct
+{
+    // Received packets a stream queues until they are released, XLINK_MAX_PACKETS_PER_STREAM by default.
+    // Writes also stop at this many packets unreleased by the remote, so both sides have to agree on it
+    uint32_t packetsPerStream;
+    // Dispatcher events outstanding each way, every blocked call holds one. XLINK_DEFAULT_EVENTS_PER_QUEUE by default.
+    // Rounded up to a power of two between 2 and 65536
+    uint32_t eventsPerQueue;
+} XLinkLinkLimits_t;
+
+#define XLINK_HANDSHAKE_VERSION 1
+
+// Features a peer announces while connecting, see XLinkGetPeerCapabilities
+#define XLINK_FEATURE_COMPACT_HEADER     (1u << 0) // reads compact headers, both sides send them once announced
+#define XLINK_FEATURE_RELEASE_COALESCING (1u << 1) // see XLinkSetReleaseCoalescing
+#define XLINK_FEATURE_BATCHED_EVENTS     (1u << 2) // reads and writes several events per transfer
+
+/**
+ * @brief What a peer announced in the connect handshake. All 0 for peers predating it.
+ *        Exchanged as is, later versions only append fields
+ */
+typedef struct
+{
+    uint32_t version;          // XLINK_HANDSHAKE_VERSION of the peer
+    uint32_t features;         // XLINK_FEATURE_* bitmap
+    uint32_t eventsPerQueue;   // see XLinkLinkLimits_t, also bounds the XLinkWriteDataAsync calls in flight
+    uint32_t packetsPerStream; // see XLinkLinkLimits_t
+} XLinkCapabilities_t;
+
 //Deprecated defines. Begin.
 
 typedef enum{
@@ -0,0 +1,76 @@
+///
+/// @file
+///
+/// @brief     Shared reader threads serving the incoming data of many links
+///
+#ifndef _XLINKREACTOR_H
+#define _XLINKREACTOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define XLINK_REACTOR_MAX_THREADS 16
+
+typedef enum {
+    XLINK_REACTOR_CONTINUE, // keep watching the descriptor
+    XLINK_REACTOR_PAUSE,    // stop watching it until XLinkReactorResume
+    XLINK_REACTOR_STOP,     // stop watching it for good
+    XLINK_REACTOR_AGAIN,    // data the descriptor doesn't signal is left, call again after the other sources
+} xLinkReactorAction_t;
+
+struct xLinkReactorSource_t;
+
+/**
+ * @brief Called on a reader thread once the descriptor is readable. Calls for
+ *        one source never overlap.
+ * @return xLinkReactorAction_t
+ */
+typedef int (*xLinkReactorReadable_t)(struct xLinkReactorSource_t* source);
+
+/**
+ * @brief Descriptor watched by the reader threads, owned by the caller
+ */
+typedef struct xLinkReactorSource_t {
+    int fd;
+    void* context;
+    xLinkReactorReadable_t onReadable;
+
+    // set by XLinkReactorAdd
+    int slot;
+    uint32_t generation;
+    int thread;
+} xLinkReactorSource_t;
+
+/**
+ * @brief Sets the number of shared reader threads, 0 (default) disables them
+ * @return 0 on success, -1 while sources are added or if the platform has no support
+ */
+int XLinkReactorSetThreads(unsigned int count);
+unsigned int XLinkReactorGetThreads(void);
+
+/**
+ * @brief Starts watching the source, reader threads start with the first one
+ * @return 0 on success, -1 if the source should be read some other way
+ */
+int XLinkReactorAdd(xLinkReactorSource_t* source);
+/**
+ * @brief Watches a source again after its callback returned XLINK_REACTOR_PAUSE.
+ *        The callback runs once right away, even if the descriptor isn't readable.
+ *        Callable from any thread.
+ */
+void XLinkReactorResume(xLinkReactorSource_t* source);
+/**
+ * @brief Stops watching the source. Once this returns its callback is neither
+ *        running nor called again. Reader threads stop with the last source.
+ */
+void XLinkReactorRemove(xLinkReactorSource_t* source);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _XLINKREACTOR_H
@@ -25,6 +25,8 @@
 # endif
 # endif
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -33,16 +35,20 @@ extern "C"
 //
 // This structure describes the semaphore used in XLink and
 // extends the standard semaphore with a reference count.
-// The counter is thread-safe and changes only in cases if
-// all tools of thread synchronization are really unlocked.
-// refs == -1 in case if semaphore was destroyed;
+// The counter is changed atomically, each semaphore on its own.
+// refs == XLINK_SEM_DESTROYED in case if semaphore was destroyed;
 // refs == 0 in case if semaphore was initialized but has no waiters;
-// refs == N in case if there are N waiters which called sem_wait().
+// refs == N in case if there are N waiters which called sem_wait(),
+// with XLINK_SEM_DESTROY_WAITING added while XLink_sem_destroy waits for them.
 //
 
+#define XLINK_SEM_DESTROYED         0xFFFFFFFFu
+#define XLINK_SEM_DESTROY_WAITING   0x40000000u
+#define XLINK_SEM_REFS_MASK         0x3FFFFFFFu
+
 typedef struct {
     sem_t psem;
-    int refs;
+    volatile uint32_t refs;
 } XLink_sem_t;
 
 //
@@ -61,14 +67,30 @@ int XLink_sem_wait(XLink_sem_t* sem);
 int XLink_sem_timedwait(XLink_sem_t* sem, const struct timespec* abstime);
 int XLink_sem_trywait(XLink_sem_t* sem);
 
+//
+// Waits at most timeoutMs, measured on a monotonic clock, so changes of the
+// system clock don't shorten or extend the wait. Fails with ETIMEDOUT.
+//
+
+int XLink_sem_timedwait_ms(XLink_sem_t* sem, unsigned int timeoutMs);
+
 //
 // Helper functions for XLink semaphore wrappers.
 // Use them only in case if you know what you are doing.
 //
 
 int XLink_sem_set_refs(XLink_sem_t* sem, int refs);
+// -1 once the semaphore was destroyed
 int XLink_sem_get_refs(XLink_sem_t* sem, int *sval);
 
+//
+// Hold the semaphore without waiting on it, XLink_sem_destroy blocks until
+// every XLink_sem_inc is matched by XLink_sem_dec.
+//
+
+int XLink_sem_inc(XLink_sem_t* sem);
+int XLink_sem_dec(XLink_sem_t* sem);
+
 #ifdef __cplusplus
 }
 #endif
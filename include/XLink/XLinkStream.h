@@ -8,6 +8,38 @@
 #include "XLinkPublicDefines.h"
 #include "XLinkSemaphore.h"
 
+/**
+ * @brief Released packet buffers kept for reuse by the same stream
+ */
+typedef struct{
+    void* data[XLINK_MAX_PACKETS_PER_STREAM];
+    uint32_t capacity[XLINK_MAX_PACKETS_PER_STREAM];
+    uint32_t count;
+    uint32_t bytes;
+    uint64_t hits;
+    uint64_t misses;
+}streamBufferPool_t;
+
+/**
+ * @brief Stream counters, updated atomically so XLinkGetStreamStats reads them without locking
+ */
+typedef struct{
+    uint64_t packetsOut;
+    uint64_t bytesOut;
+    uint64_t packetsIn;
+    uint64_t bytesIn;
+    uint64_t drops;
+    uint64_t nacks;
+    uint64_t blockedWriteUs;
+    uint64_t blockedReadUs;
+    uint32_t callLatency[XLINK_STATS_LATENCY_BUCKETS];
+    uint32_t transitLatency[XLINK_STATS_LATENCY_BUCKETS];
+
+    // start of the current blocked period, 0 if none, used under the stream semaphore
+    uint64_t writeBlockedSinceUs;
+    uint64_t readBlockedSinceUs;
+}streamStats_t;
+
 /**
  * @brief Streams opened to device
  */
@@ -17,7 +49,9 @@ typedef struct{
     uint32_t writeSize;
     uint32_t readSize;  /*No need of read buffer. It's on remote,
     will read it directly to the requested buffer*/
-    streamPacketDesc_t packets[XLINK_MAX_PACKETS_PER_STREAM];
+    streamPacketDesc_t* packets; // circular buffer of packetCapacity packets
+    uint32_t packetCapacity;     // packets this side holds for the stream
+    uint32_t remotePacketCapacity; // packets the remote holds for the stream, bounds the writes
     uint32_t availablePackets;
     uint32_t blockedPackets;
 
@@ -28,15 +62,58 @@ typedef struct{
     uint32_t remoteFillLevel;
     uint32_t localFillLevel;
     uint32_t remoteFillPacketLevel;
+    uint32_t blockedWrites; // local writes waiting for remote space, in order
 
     uint32_t closeStreamInitiated;
 
+    // Caller owned receive buffers, see XLinkRegisterReadBuffers
+    void* readBuffers[XLINK_MAX_PACKETS_PER_STREAM];
+    uint32_t readBuffersCount;
+    uint32_t readBufferSize;
+    uint64_t readBuffersFree; // bit set - buffer is not holding a packet
+
+    streamBufferPool_t pool;
+
+    // Releases not yet acknowledged to the remote, see XLinkSetReleaseCoalescing
+    uint32_t releaseCreditPackets;
+    uint32_t releaseCreditBytes;
+    uint64_t releaseCreditSinceMs; // monotonic time of the oldest withheld release
+
+    streamStats_t stats;
+
     XLink_sem_t sem;
 }streamDesc_t;
 
+#define XLINK_READ_BUFFERS_MASK(count) \
+    ((count) >= 64 ? ~0ULL : ((1ULL << (count)) - 1))
+
+struct xLinkDeviceHandle_t;
+
 XLinkError_t XLinkStreamInitialize(
-    streamDesc_t* stream, streamId_t id, const char* name);
+    streamDesc_t* stream, streamId_t id, const char* name, uint32_t packetCapacity);
 
 void XLinkStreamReset(streamDesc_t* stream);
 
+/**
+ * @brief Allocates a packet buffer, reusing one released to the stream pool when possible.
+ *        New buffers are receive buffers of the given link, see XLinkPlatformAllocateDeviceData
+ */
+void* XLinkStreamAllocateData(streamDesc_t* stream, struct xLinkDeviceHandle_t* deviceHandle, uint32_t size);
+/**
+ * @brief Returns a packet buffer to the stream pool, or frees it if the pool is full.
+ *        Pooled bytes are bounded by the stream readSize.
+ */
+void XLinkStreamDeallocateData(streamDesc_t* stream, void* data, uint32_t size);
+void XLinkStreamDrainPool(streamDesc_t* stream);
+
+/**
+ * @brief Counts a latency into its histogram bucket, see XLINK_STATS_BUCKET_LOWER_US
+ */
+void XLinkStreamRecordLatency(uint32_t* histogram, uint64_t us);
+/**
+ * @brief Ends a blocked period started at *sinceUs, adding its length to *totalUs
+ */
+void XLinkStreamEndBlocked(uint64_t* sinceUs, uint64_t* totalUs);
+void XLinkStreamGetStats(streamDesc_t* stream, XLinkStreamStats_t* stats);
+
 #endif //_XLINKSTREAM_H
@@ -12,6 +12,9 @@ typedef struct XLinkTimespec {
 } XLinkTimespec;
 
 void getMonotonicTimestamp(XLinkTimespec* ts);
+uint64_t getMonotonicTimestampMs(void);
+uint64_t getMonotonicTimestampUs(void);
+uint64_t getMonotonicTimestampNs(void);
 
 #ifdef __cplusplus
 }
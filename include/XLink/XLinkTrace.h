@@ -0,0 +1,63 @@
+///
+/// @file
+///
+/// @brief     Per link ring of binary trace records following events through the dispatcher
+///
+#ifndef _XLINKTRACE_H
+#define _XLINKTRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef XLINK_TRACE_RING_SIZE
+#define XLINK_TRACE_RING_SIZE 1024 // records kept per link, a power of two
+#endif
+
+typedef enum {
+    XLINK_TRACE_EVENT_ADDED,     // DispatcherAddEvent
+    XLINK_TRACE_EVENT_PICKED,    // taken off the queues by the scheduler
+    XLINK_TRACE_SEND_BEGIN,      // event or its response being written to the link
+    XLINK_TRACE_SEND_END,
+    XLINK_TRACE_HEADER_RECEIVED, // header of a remote event read off the link
+    XLINK_TRACE_EVENT_SERVED,
+} xLinkTraceStage_t;
+
+typedef struct {
+    volatile uint32_t ticket; // position in the ring plus one, 0 while written
+    uint8_t stage;            // xLinkTraceStage_t
+    uint8_t remote;           // event came from the remote
+    uint16_t type;            // xLinkEventType_t
+    int32_t eventId;
+    uint32_t streamId;
+    uint32_t size;
+    uint64_t timeNs;          // monotonic
+} xLinkTraceRecord_t;
+
+/**
+ * @brief Written by any thread without locking, the oldest records are overwritten
+ */
+typedef struct {
+    volatile uint32_t head; // records ever written
+    xLinkTraceRecord_t records[XLINK_TRACE_RING_SIZE];
+} xLinkTraceRing_t;
+
+void XLinkTraceReset(xLinkTraceRing_t* ring);
+void XLinkTraceRecord(xLinkTraceRing_t* ring, xLinkTraceStage_t stage, int remote,
+                      uint32_t type, int32_t eventId, uint32_t streamId, uint32_t size);
+
+/**
+ * @brief Writes the records in Chrome trace event format, as loaded by Perfetto or chrome://tracing.
+ *        Records overwritten while copying are skipped.
+ * @return 0 on success
+ */
+int XLinkTraceWriteChrome(xLinkTraceRing_t* ring, uint32_t linkId, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _XLINKTRACE_H
@@ -16,6 +16,7 @@
 #include "tcpip_host.h"
 #include "PlatformDeviceFd.h"
 #include "inttypes.h"
+#include "XLinkProbes.h"
 
 #define MVLOG_UNIT_NAME PlatformData
 #include "XLinkLog.h"
@@ -31,6 +32,7 @@
 #pragma comment(lib, "Ws2_32.lib")
 #else
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <unistd.h>
@@ -63,9 +65,21 @@ extern int usbFdRead;
 
 static int pciePlatformRead(void *f, void *data, int size);
 static int tcpipPlatformRead(void *fd, void *data, int size);
+static int tcpipPlatformReadNonBlocking(void *fd, void *data, int size);
+static int tcpipPlatformReadAtLeast(void *fd, void *data, int size, int capacity);
+static int tcpipPlatformGetPollFd(void *fd);
 
 static int pciePlatformWrite(void *f, void *data, int size);
 static int tcpipPlatformWrite(void *fd, void *data, int size);
+static int tcpipPlatformWritev(void *fd, const xLinkPlatformIoVec_t *iov, int iovcnt);
+
+// Dispatch to the protocol, XLinkPlatform* add the tracepoints around them
+static int platformWrite(xLinkDeviceHandle_t *deviceHandle, void *data, int size);
+static int platformWritev(xLinkDeviceHandle_t *deviceHandle, const xLinkPlatformIoVec_t *iov, int iovcnt);
+static int platformWriteTransfers(xLinkDeviceHandle_t *deviceHandle, const xLinkPlatformIoVec_t *iov, int iovcnt);
+static int platformRead(xLinkDeviceHandle_t *deviceHandle, void *data, int size);
+static int platformReadNonBlocking(xLinkDeviceHandle_t *deviceHandle, void *data, int size);
+static int platformReadAtLeast(xLinkDeviceHandle_t *deviceHandle, void *data, int size, int capacity);
 
 // ------------------------------------
 // Wrappers declaration. End.
@@ -79,46 +93,70 @@ static int tcpipPlatformWrite(void *fd, void *data, int size);
 
 int XLinkPlatformWrite(xLinkDeviceHandle_t *deviceHandle, void *data, int size)
 {
-    if(!XLinkIsProtocolInitialized(deviceHandle->protocol)) {
-        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+deviceHandle->protocol;
-    }
-
-    switch (deviceHandle->protocol) {
-        case X_LINK_USB_VSC:
-        case X_LINK_USB_CDC:
-            return usbPlatformWrite(deviceHandle->xLinkFD, data, size);
-
-        case X_LINK_PCIE:
-            return pciePlatformWrite(deviceHandle->xLinkFD, data, size);
-
-        case X_LINK_TCP_IP:
-            return tcpipPlatformWrite(deviceHandle->xLinkFD, data, size);
+    XLINK_PROBE2(platform_write_begin, deviceHandle->xLinkFD, size);
+    int rc = platformWrite(deviceHandle, data, size);
+    XLINK_PROBE3(platform_write_end, deviceHandle->xLinkFD, size, rc);
+    return rc;
+}
 
-        default:
-            return X_LINK_PLATFORM_INVALID_PARAMETERS;
+int XLinkPlatformWritev(xLinkDeviceHandle_t *deviceHandle, const xLinkPlatformIoVec_t *iov, int iovcnt)
+{
+#ifdef XLINK_ENABLE_USDT
+    int size = 0;
+    for(int i = 0; i < iovcnt; i++) {
+        size += iov[i].size;
     }
+#endif
+    XLINK_PROBE2(platform_write_begin, deviceHandle->xLinkFD, size);
+    int rc = platformWritev(deviceHandle, iov, iovcnt);
+    XLINK_PROBE3(platform_write_end, deviceHandle->xLinkFD, size, rc);
+    return rc;
 }
 
-int XLinkPlatformRead(xLinkDeviceHandle_t *deviceHandle, void *data, int size)
+int XLinkPlatformWriteTransfers(xLinkDeviceHandle_t *deviceHandle, const xLinkPlatformIoVec_t *iov, int iovcnt)
 {
-    if(!XLinkIsProtocolInitialized(deviceHandle->protocol)) {
-        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+deviceHandle->protocol;
+#ifdef XLINK_ENABLE_USDT
+    int size = 0;
+    for(int i = 0; i < iovcnt; i++) {
+        size += iov[i].size;
     }
+#endif
+    XLINK_PROBE2(platform_write_begin, deviceHandle->xLinkFD, size);
+    int rc = platformWriteTransfers(deviceHandle, iov, iovcnt);
+    XLINK_PROBE3(platform_write_end, deviceHandle->xLinkFD, size, rc);
+    return rc;
+}
 
-    switch (deviceHandle->protocol) {
-        case X_LINK_USB_VSC:
-        case X_LINK_USB_CDC:
-            return usbPlatformRead(deviceHandle->xLinkFD, data, size);
+int XLinkPlatformRead(xLinkDeviceHandle_t *deviceHandle, void *data, int size)
+{
+    XLINK_PROBE2(platform_read_begin, deviceHandle->xLinkFD, size);
+    int rc = platformRead(deviceHandle, data, size);
+    XLINK_PROBE3(platform_read_end, deviceHandle->xLinkFD, size, rc);
+    return rc;
+}
 
-        case X_LINK_PCIE:
-            return pciePlatformRead(deviceHandle->xLinkFD, data, size);
+int XLinkPlatformReadNonBlocking(xLinkDeviceHandle_t *deviceHandle, void *data, int size)
+{
+    XLINK_PROBE2(platform_read_begin, deviceHandle->xLinkFD, size);
+    int rc = platformReadNonBlocking(deviceHandle, data, size);
+    XLINK_PROBE3(platform_read_end, deviceHandle->xLinkFD, size, rc);
+    return rc;
+}
 
-        case X_LINK_TCP_IP:
-            return tcpipPlatformRead(deviceHandle->xLinkFD, data, size);
+int XLinkPlatformReadAtLeast(xLinkDeviceHandle_t *deviceHandle, void *data, int size, int capacity)
+{
+    XLINK_PROBE2(platform_read_begin, deviceHandle->xLinkFD, size);
+    int rc = platformReadAtLeast(deviceHandle, data, size, capacity);
+    XLINK_PROBE3(platform_read_end, deviceHandle->xLinkFD, size, rc);
+    return rc;
+}
 
-        default:
-            return X_LINK_PLATFORM_INVALID_PARAMETERS;
+int XLinkPlatformGetPollFd(xLinkDeviceHandle_t *deviceHandle)
+{
+    if(deviceHandle->protocol == X_LINK_TCP_IP && XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        return tcpipPlatformGetPollFd(deviceHandle->xLinkFD);
     }
+    return -1;
 }
 
 void* XLinkPlatformAllocateData(uint32_t size, uint32_t alignment)
@@ -134,10 +172,26 @@ void* XLinkPlatformAllocateData(uint32_t size, uint32_t alignment)
     return ret;
 }
 
+void* XLinkPlatformAllocateDeviceData(xLinkDeviceHandle_t *deviceHandle, uint32_t size, uint32_t alignment)
+{
+    void* ret = NULL;
+    if (deviceHandle->protocol == X_LINK_USB_VSC &&
+        XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        // page aligned, which covers the requested alignment
+        ret = usbPlatformAllocateData(deviceHandle->xLinkFD, size);
+    }
+    if (ret == NULL) {
+        ret = XLinkPlatformAllocateData(size, alignment);
+    }
+    return ret;
+}
+
 void XLinkPlatformDeallocateData(void *ptr, uint32_t size, uint32_t alignment)
 {
     if (!ptr)
         return;
+    if (usbPlatformDeallocateData(ptr) == 0)
+        return;
 #if (defined(_WIN32) || defined(_WIN64) )
     _aligned_free(ptr);
 #else
@@ -290,6 +344,71 @@ static int tcpipPlatformRead(void *fdKey, void *data, int size)
     return 0;
 }
 
+static int tcpipPlatformReadNonBlocking(void *fdKey, void *data, int size)
+{
+#if defined(USE_TCP_IP) && defined(MSG_DONTWAIT)
+    void* tmpsockfd = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &tmpsockfd)){
+        mvLog(MVLOG_FATAL, "Cannot find file descriptor by key: %" PRIxPTR, (uintptr_t) fdKey);
+        return -1;
+    }
+    TCPIP_SOCKET sock = (TCPIP_SOCKET) (uintptr_t) tmpsockfd;
+
+    // The socket itself stays blocking, writes from the scheduler rely on it
+    int rc = recv(sock, data, size, MSG_DONTWAIT);
+    if(rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;
+    }
+    if(rc <= 0) {
+        return -1;
+    }
+    return rc;
+#else
+    return X_LINK_PLATFORM_INVALID_PARAMETERS;
+#endif
+}
+
+static int tcpipPlatformReadAtLeast(void *fdKey, void *data, int size, int capacity)
+{
+#if defined(USE_TCP_IP)
+    int nread = 0;
+
+    void* tmpsockfd = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &tmpsockfd)){
+        mvLog(MVLOG_FATAL, "Cannot find file descriptor by key: %" PRIxPTR, (uintptr_t) fdKey);
+        return -1;
+    }
+    TCPIP_SOCKET sock = (TCPIP_SOCKET) (uintptr_t) tmpsockfd;
+
+    // each call returns what was received so far, beyond size if there is more
+    while(nread < size)
+    {
+        int rc = recv(sock, &((char*)data)[nread], capacity - nread, 0);
+        if(rc <= 0)
+        {
+            return -1;
+        }
+        nread += rc;
+    }
+    return nread;
+#else
+    return X_LINK_PLATFORM_INVALID_PARAMETERS;
+#endif
+}
+
+static int tcpipPlatformGetPollFd(void *fdKey)
+{
+#if defined(USE_TCP_IP) && defined(MSG_DONTWAIT)
+    void* tmpsockfd = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &tmpsockfd)){
+        return -1;
+    }
+    return (int) (uintptr_t) tmpsockfd;
+#else
+    return -1;
+#endif
+}
+
 static int tcpipPlatformWrite(void *fdKey, void *data, int size)
 {
 #if defined(USE_TCP_IP)
@@ -327,6 +446,203 @@ static int tcpipPlatformWrite(void *fdKey, void *data, int size)
     return 0;
 }
 
+static int tcpipPlatformWritev(void *fdKey, const xLinkPlatformIoVec_t *iov, int iovcnt)
+{
+#if defined(USE_TCP_IP)
+    void* tmpsockfd = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &tmpsockfd)){
+        mvLog(MVLOG_FATAL, "Cannot find file descriptor by key: %" PRIxPTR, (uintptr_t) fdKey);
+        return -1;
+    }
+    TCPIP_SOCKET sock = (TCPIP_SOCKET) (uintptr_t) tmpsockfd;
+
+    // Index of the first buffer not yet fully sent and offset into it
+    int current = 0;
+    int offset = 0;
+
+    while(current < iovcnt)
+    {
+        if(iov[current].size - offset <= 0) {
+            current++;
+            offset = 0;
+            continue;
+        }
+
+        int count = 0;
+#if (defined(_WIN32) || defined(_WIN64))
+        WSABUF bufs[XLINK_PLATFORM_MAX_IOV];
+        for(int i = current; i < iovcnt && count < XLINK_PLATFORM_MAX_IOV; i++) {
+            int skip = (i == current) ? offset : 0;
+            bufs[count].buf = (CHAR*) iov[i].data + skip;
+            bufs[count].len = (ULONG) (iov[i].size - skip);
+            count++;
+        }
+
+        DWORD sent = 0;
+        if(WSASend(sock, bufs, count, &sent, 0, NULL, NULL) != 0 || sent == 0)
+        {
+            return -1;
+        }
+        int rc = (int) sent;
+#else
+        struct iovec bufs[XLINK_PLATFORM_MAX_IOV];
+        for(int i = current; i < iovcnt && count < XLINK_PLATFORM_MAX_IOV; i++) {
+            int skip = (i == current) ? offset : 0;
+            bufs[count].iov_base = (char*) iov[i].data + skip;
+            bufs[count].iov_len = (size_t) (iov[i].size - skip);
+            count++;
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = bufs;
+        msg.msg_iovlen = count;
+
+        int flags = 0;
+        #if defined(MSG_NOSIGNAL)
+            // Use flag NOSIGNAL on send call
+            flags = MSG_NOSIGNAL;
+        #endif
+
+        ssize_t sent = sendmsg(sock, &msg, flags);
+        if(sent <= 0)
+        {
+            return -1;
+        }
+        int rc = (int) sent;
+#endif
+        // Advance past fully sent buffers, handling short writes
+        while(current < iovcnt && rc >= iov[current].size - offset) {
+            rc -= iov[current].size - offset;
+            offset = 0;
+            current++;
+        }
+        offset += rc;
+    }
+#endif
+    return 0;
+}
+
+static int platformWrite(xLinkDeviceHandle_t *deviceHandle, void *data, int size)
+{
+    if(!XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+deviceHandle->protocol;
+    }
+
+    switch (deviceHandle->protocol) {
+        case X_LINK_USB_VSC:
+        case X_LINK_USB_CDC:
+            return usbPlatformWrite(deviceHandle->xLinkFD, data, size);
+
+        case X_LINK_PCIE:
+            return pciePlatformWrite(deviceHandle->xLinkFD, data, size);
+
+        case X_LINK_TCP_IP:
+            return tcpipPlatformWrite(deviceHandle->xLinkFD, data, size);
+
+        default:
+            return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+}
+
+static int platformWritev(xLinkDeviceHandle_t *deviceHandle, const xLinkPlatformIoVec_t *iov, int iovcnt)
+{
+    if(!XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+deviceHandle->protocol;
+    }
+
+    if(deviceHandle->protocol == X_LINK_TCP_IP) {
+        return tcpipPlatformWritev(deviceHandle->xLinkFD, iov, iovcnt);
+    }
+
+    // Message based transports: one transfer per buffer
+    for(int i = 0; i < iovcnt; i++) {
+        int rc = platformWrite(deviceHandle, iov[i].data, iov[i].size);
+        if(rc) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+static int platformWriteTransfers(xLinkDeviceHandle_t *deviceHandle, const xLinkPlatformIoVec_t *iov, int iovcnt)
+{
+    if(deviceHandle->protocol != X_LINK_USB_VSC) {
+        return platformWritev(deviceHandle, iov, iovcnt);
+    }
+    if(!XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+deviceHandle->protocol;
+    }
+
+    for(int i = 0; i < iovcnt; i++) {
+        int rc = usbPlatformWriteTransfer(deviceHandle->xLinkFD, iov[i].data, iov[i].size);
+        if(rc) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+static int platformRead(xLinkDeviceHandle_t *deviceHandle, void *data, int size)
+{
+    if(!XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+deviceHandle->protocol;
+    }
+
+    switch (deviceHandle->protocol) {
+        case X_LINK_USB_VSC:
+        case X_LINK_USB_CDC:
+            return usbPlatformRead(deviceHandle->xLinkFD, data, size);
+
+        case X_LINK_PCIE:
+            return pciePlatformRead(deviceHandle->xLinkFD, data, size);
+
+        case X_LINK_TCP_IP:
+            return tcpipPlatformRead(deviceHandle->xLinkFD, data, size);
+
+        default:
+            return X_LINK_PLATFORM_INVALID_PARAMETERS;
+    }
+}
+
+static int platformReadNonBlocking(xLinkDeviceHandle_t *deviceHandle, void *data, int size)
+{
+    if(!XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+deviceHandle->protocol;
+    }
+
+    if(deviceHandle->protocol == X_LINK_TCP_IP) {
+        return tcpipPlatformReadNonBlocking(deviceHandle->xLinkFD, data, size);
+    }
+    return X_LINK_PLATFORM_INVALID_PARAMETERS;
+}
+
+static int platformReadAtLeast(xLinkDeviceHandle_t *deviceHandle, void *data, int size, int capacity)
+{
+    if(!XLinkIsProtocolInitialized(deviceHandle->protocol)) {
+        return X_LINK_PLATFORM_DRIVER_NOT_LOADED+deviceHandle->protocol;
+    }
+
+    if(deviceHandle->protocol == X_LINK_TCP_IP) {
+        return tcpipPlatformReadAtLeast(deviceHandle->xLinkFD, data, size, capacity);
+    }
+    if(deviceHandle->protocol == X_LINK_USB_VSC) {
+        // whole transfers, as the remote ended them
+        int received = 0;
+        while(received < size) {
+            int rc = usbPlatformReadTransfer(deviceHandle->xLinkFD, (uint8_t*)data + received, capacity - received);
+            if(rc < 0) {
+                return rc;
+            }
+            received += rc;
+        }
+        return received;
+    }
+    // transfers of other message based transports end where the remote wrote them
+    int rc = platformRead(deviceHandle, data, size);
+    return rc < 0 ? rc : size;
+}
+
 // ------------------------------------
 // Wrappers implementation. End.
 // ------------------------------------
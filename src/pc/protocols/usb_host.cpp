@@ -3,7 +3,10 @@
 
 // std
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <unordered_map>
+#include <unordered_set>
 #include <algorithm>
 #include <string>
 #include <thread>
@@ -39,6 +42,14 @@ static constexpr int USB_ENDPOINT_OUT = 0x01;
 
 static constexpr int XLINK_USB_DATA_TIMEOUT = 0;
 
+// Bulk transfers kept in flight per read or write, so the bus doesn't idle between chunks
+#ifndef XLINK_USB_TRANSFERS_IN_FLIGHT
+#define XLINK_USB_TRANSFERS_IN_FLIGHT 4
+#endif
+static constexpr int USB_TRANSFERS_IN_FLIGHT = XLINK_USB_TRANSFERS_IN_FLIGHT > 0 ? XLINK_USB_TRANSFERS_IN_FLIGHT : 1;
+// Size of each of these transfers, a multiple of the max packet size of USB2 and USB3 bulk endpoints
+static constexpr int USB_TRANSFER_CHUNKSZ = 256 * 1024;
+
 static unsigned int bulk_chunklen = DEFAULT_CHUNKSZ;
 static int write_timeout = DEFAULT_WRITE_TIMEOUT;
 static int initialized;
@@ -98,6 +109,9 @@ static std::unordered_map<VidPid, XLinkDeviceState_t, pair_hash> vidPidToDeviceS
 static std::string getLibusbDevicePath(libusb_device *dev);
 static libusb_error getLibusbDeviceMxId(XLinkDeviceState_t state, std::string devicePath, const libusb_device_descriptor* pDesc, libusb_device *dev, std::string& outMxId);
 static const char* xlink_libusb_strerror(int x);
+static void usbEventThreadAcquire();
+static void usbEventThreadRelease();
+static bool usbDeviceMemoryInUse(libusb_device_handle* h);
 #ifdef _WIN32
 std::string getWinUsbMxId(VidPid vidpid, libusb_device* dev);
 #endif
@@ -752,12 +766,98 @@ xLinkPlatformErrorCode_t usbLinkBootBootloader(const char *path) {
     return X_LINK_PLATFORM_SUCCESS;
 }
 
+// usbfs DMA buffers handed out as packet data, by address. The device handle
+// is kept open while any of them is still held, as freeing them needs it.
+struct UsbDeviceMemory {
+    libusb_device_handle* handle;
+    size_t size;
+};
+static std::mutex deviceMemoryMutex;
+static std::unordered_map<void*, UsbDeviceMemory> deviceMemory;
+static std::unordered_map<libusb_device_handle*, int> deviceMemoryPerHandle;
+static std::unordered_set<libusb_device_handle*> closePendingHandles;
+static std::atomic<int> deviceMemoryCount{0};
+
+static bool usbDeviceMemoryInUse(libusb_device_handle* h)
+{
+    std::lock_guard<std::mutex> lock(deviceMemoryMutex);
+    if(deviceMemoryPerHandle.count(h) == 0) {
+        return false;
+    }
+    closePendingHandles.insert(h);
+    return true;
+}
+
 void usbLinkClose(libusb_device_handle *f)
 {
     libusb_release_interface(f, 0);
+    // closed once the last DMA buffer of the handle is freed instead
+    if(usbDeviceMemoryInUse(f)) {
+        return;
+    }
     libusb_close(f);
 }
 
+void* usbPlatformAllocateData(void *fdKey, uint32_t size)
+{
+#if defined(USE_USB_VSC) && defined(__linux__) && defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+    void* tmpUsbHandle = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &tmpUsbHandle)){
+        return nullptr;
+    }
+    libusb_device_handle* usbHandle = (libusb_device_handle*) tmpUsbHandle;
+
+    // fails once the usbfs memory limit is reached, the caller falls back to regular memory
+    unsigned char* data = libusb_dev_mem_alloc(usbHandle, size);
+    if(data == nullptr) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(deviceMemoryMutex);
+    deviceMemory[data] = UsbDeviceMemory{usbHandle, size};
+    deviceMemoryPerHandle[usbHandle]++;
+    deviceMemoryCount++;
+    return data;
+#else
+    (void)fdKey;
+    (void)size;
+    return nullptr;
+#endif
+}
+
+int usbPlatformDeallocateData(void *data)
+{
+#if defined(USE_USB_VSC) && defined(__linux__) && defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+    if(deviceMemoryCount == 0) {
+        return -1;
+    }
+    libusb_device_handle* closeHandle = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(deviceMemoryMutex);
+        auto it = deviceMemory.find(data);
+        if(it == deviceMemory.end()) {
+            return -1;
+        }
+        libusb_device_handle* usbHandle = it->second.handle;
+        libusb_dev_mem_free(usbHandle, (unsigned char*)data, it->second.size);
+        deviceMemory.erase(it);
+        deviceMemoryCount--;
+        if(--deviceMemoryPerHandle[usbHandle] == 0) {
+            deviceMemoryPerHandle.erase(usbHandle);
+            if(closePendingHandles.erase(usbHandle)) {
+                closeHandle = usbHandle;
+            }
+        }
+    }
+    if(closeHandle) {
+        libusb_close(closeHandle);
+    }
+    return 0;
+#else
+    (void)data;
+    return -1;
+#endif
+}
+
 
 
 int usbPlatformConnect(const char *devPathRead, const char *devPathWrite, void **fd)
@@ -863,6 +963,7 @@ int usbPlatformConnect(const char *devPathRead, const char *devPathWrite, void *
     // Store the usb handle and create a "unique" key instead
     // (as file descriptors are reused and can cause a clash with lookups between scheduler and link)
     *fd = createPlatformDeviceFdKey(usbHandle);
+    usbEventThreadAcquire();
 
 #endif  /*USE_USB_VSC*/
 
@@ -894,6 +995,7 @@ int usbPlatformClose(void *fdKey)
         return -1;
     }
     usbLinkClose((libusb_device_handle *) tmpUsbHandle);
+    usbEventThreadRelease();
 
     if(destroyPlatformDeviceFdKey(fdKey)){
         mvLog(MVLOG_FATAL, "Cannot destroy USB Handle key: %" PRIxPTR, (uintptr_t) fdKey);
@@ -919,38 +1021,172 @@ int usbPlatformBootFirmware(const deviceDesc_t* deviceDesc, const char* firmware
 
 
 
-int usb_read(libusb_device_handle *f, void *data, size_t size)
+// Asynchronous transfers complete on a libusb event thread, running while any link is open
+static std::mutex eventThreadMutex;
+static std::thread eventThread;
+static std::atomic<bool> eventThreadRunning{false};
+static int eventThreadUsers = 0;
+
+static void usbEventThreadAcquire()
 {
-    const int chunk_size = DEFAULT_CHUNKSZ;
-    while(size > 0)
-    {
-        int bt, ss = (int)size;
-        if(ss > chunk_size)
-            ss = chunk_size;
-        int rc = libusb_bulk_transfer(f, USB_ENDPOINT_IN,(unsigned char *)data, ss, &bt, XLINK_USB_DATA_TIMEOUT);
-        if(rc)
-            return rc;
-        data = ((char *)data) + bt;
-        size -= bt;
+    std::lock_guard<std::mutex> lock(eventThreadMutex);
+    if(eventThreadUsers++ > 0) {
+        return;
     }
-    return 0;
+    eventThreadRunning = true;
+    eventThread = std::thread([](){
+        while(eventThreadRunning) {
+            // bounded, so a stop request is noticed without pending transfers
+            struct timeval tv = {0, 100000};
+            int rc = libusb_handle_events_timeout_completed(context, &tv, nullptr);
+            if(rc && rc != LIBUSB_ERROR_INTERRUPTED) {
+                mvLog(MVLOG_ERROR, "libusb_handle_events failed: %s", xlink_libusb_strerror(rc));
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+    });
 }
 
-int usb_write(libusb_device_handle *f, const void *data, size_t size)
+static void usbEventThreadRelease()
 {
-    const int chunk_size = DEFAULT_CHUNKSZ;
-    while(size > 0)
-    {
-        int bt, ss = (int)size;
-        if(ss > chunk_size)
-            ss = chunk_size;
-        int rc = libusb_bulk_transfer(f, USB_ENDPOINT_OUT, (unsigned char *)data, ss, &bt, XLINK_USB_DATA_TIMEOUT);
-        if(rc)
-            return rc;
-        data = (char *)data + bt;
-        size -= bt;
+    std::lock_guard<std::mutex> lock(eventThreadMutex);
+    if(eventThreadUsers == 0 || --eventThreadUsers > 0) {
+        return;
     }
-    return 0;
+    eventThreadRunning = false;
+    if(eventThread.joinable()) {
+        eventThread.join();
+    }
+}
+
+struct UsbTransferSlot {
+    libusb_transfer* transfer = nullptr;
+    bool done = false;
+    std::mutex* mutex = nullptr;
+    std::condition_variable* cv = nullptr;
+};
+
+static void LIBUSB_CALL usbTransferComplete(libusb_transfer* transfer)
+{
+    UsbTransferSlot* slot = static_cast<UsbTransferSlot*>(transfer->user_data);
+    // notify while locked, the waiter owns the slot once it sees done
+    std::lock_guard<std::mutex> lock(*slot->mutex);
+    slot->done = true;
+    slot->cv->notify_all();
+}
+
+static int usbTransferStatusToError(libusb_transfer_status status)
+{
+    switch(status) {
+        case LIBUSB_TRANSFER_COMPLETED: return LIBUSB_SUCCESS;
+        case LIBUSB_TRANSFER_TIMED_OUT: return LIBUSB_ERROR_TIMEOUT;
+        case LIBUSB_TRANSFER_STALL: return LIBUSB_ERROR_PIPE;
+        case LIBUSB_TRANSFER_NO_DEVICE: return LIBUSB_ERROR_NO_DEVICE;
+        case LIBUSB_TRANSFER_OVERFLOW: return LIBUSB_ERROR_OVERFLOW;
+        default: return LIBUSB_ERROR_IO;
+    }
+}
+
+/**
+ * @brief Transfers size bytes on a bulk endpoint with up to USB_TRANSFERS_IN_FLIGHT
+ *        chunks submitted at once. Chunks complete in submission order.
+ * @return 0 on success, libusb_error otherwise
+ */
+static int usb_transfer(libusb_device_handle *f, unsigned char endpoint, unsigned char *data, size_t size)
+{
+    const bool isIn = (endpoint & LIBUSB_ENDPOINT_DIR_MASK) == LIBUSB_ENDPOINT_IN;
+    std::mutex mutex;
+    std::condition_variable cv;
+    UsbTransferSlot slots[USB_TRANSFERS_IN_FLIGHT];
+    for(auto& slot : slots) {
+        slot.mutex = &mutex;
+        slot.cv = &cv;
+    }
+
+    int rc = LIBUSB_SUCCESS;
+    size_t placed = 0;      // bytes transferred, contiguous from data
+    size_t submitted = 0;   // offset of the next chunk to submit
+    int head = 0, inFlight = 0;
+    bool cancelled = false;
+
+    while(inFlight > 0 || (rc == LIBUSB_SUCCESS && placed < size)) {
+        while(!cancelled && rc == LIBUSB_SUCCESS && inFlight < USB_TRANSFERS_IN_FLIGHT && submitted < size) {
+            UsbTransferSlot& slot = slots[(head + inFlight) % USB_TRANSFERS_IN_FLIGHT];
+            if(slot.transfer == nullptr && (slot.transfer = libusb_alloc_transfer(0)) == nullptr) {
+                rc = LIBUSB_ERROR_NO_MEM;
+                break;
+            }
+            int length = (int)std::min<size_t>(size - submitted, USB_TRANSFER_CHUNKSZ);
+            libusb_fill_bulk_transfer(slot.transfer, f, endpoint, data + submitted, length,
+                                      usbTransferComplete, &slot, XLINK_USB_DATA_TIMEOUT);
+            slot.done = false;
+            if((rc = libusb_submit_transfer(slot.transfer)) != LIBUSB_SUCCESS) {
+                break;
+            }
+            submitted += length;
+            inFlight++;
+        }
+        if(inFlight == 0) {
+            break;
+        }
+        if(rc != LIBUSB_SUCCESS && !cancelled) {
+            for(int i = 0; i < inFlight; i++) {
+                libusb_cancel_transfer(slots[(head + i) % USB_TRANSFERS_IN_FLIGHT].transfer);
+            }
+            cancelled = true;
+        }
+
+        UsbTransferSlot& slot = slots[head];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&slot](){ return slot.done; });
+        }
+        head = (head + 1) % USB_TRANSFERS_IN_FLIGHT;
+        inFlight--;
+
+        libusb_transfer* transfer = slot.transfer;
+        if(transfer->status != LIBUSB_TRANSFER_COMPLETED && transfer->status != LIBUSB_TRANSFER_CANCELLED && rc == LIBUSB_SUCCESS) {
+            rc = usbTransferStatusToError(transfer->status);
+        }
+        if(transfer->actual_length > 0 && transfer->buffer != data + placed) {
+            // an earlier chunk came back short, so this one was submitted too far ahead
+            if(isIn) {
+                memmove(data + placed, transfer->buffer, transfer->actual_length);
+            } else if(rc == LIBUSB_SUCCESS) {
+                rc = LIBUSB_ERROR_IO;
+            }
+        }
+        placed += transfer->actual_length;
+
+        if(!cancelled && transfer->actual_length < transfer->length) {
+            // short transfer, take back the chunks after it and continue from the data received so far
+            for(int i = 0; i < inFlight; i++) {
+                libusb_cancel_transfer(slots[(head + i) % USB_TRANSFERS_IN_FLIGHT].transfer);
+            }
+            cancelled = true;
+        }
+        if(cancelled && inFlight == 0 && rc == LIBUSB_SUCCESS) {
+            cancelled = false;
+            submitted = placed;
+        }
+    }
+
+    for(auto& slot : slots) {
+        if(slot.transfer) {
+            libusb_free_transfer(slot.transfer);
+        }
+    }
+    return rc;
+}
+
+int usb_read(libusb_device_handle *f, void *data, size_t size)
+{
+    return usb_transfer(f, USB_ENDPOINT_IN, (unsigned char *)data, size);
+}
+
+int usb_write(libusb_device_handle *f, const void *data, size_t size)
+{
+    return usb_transfer(f, USB_ENDPOINT_OUT, (unsigned char *)data, size);
 }
 
 int usbPlatformRead(void* fdKey, void* data, int size)
@@ -1062,6 +1298,59 @@ int usbPlatformWrite(void *fdKey, void *data, int size)
     return rc;
 }
 
+int usbPlatformReadTransfer(void *fdKey, void *data, int capacity)
+{
+#ifndef USE_USB_VSC
+    // no transfer boundaries to read up to
+    return -1;
+#else
+    void* tmpUsbHandle = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &tmpUsbHandle)){
+        mvLog(MVLOG_FATAL, "Cannot find file descriptor by key: %" PRIxPTR, (uintptr_t) fdKey);
+        return -1;
+    }
+    libusb_device_handle* usbHandle = (libusb_device_handle*) tmpUsbHandle;
+
+    // A transfer longer than the request overflows it, so request whole packets
+    int maxPacketSize = libusb_get_max_packet_size(libusb_get_device(usbHandle), USB_ENDPOINT_IN);
+    if(maxPacketSize > 0) {
+        capacity -= capacity % maxPacketSize;
+    }
+    int transferred = 0;
+    int rc = libusb_bulk_transfer(usbHandle, USB_ENDPOINT_IN, (unsigned char *)data, capacity, &transferred, XLINK_USB_DATA_TIMEOUT);
+    if(rc != LIBUSB_SUCCESS) {
+        return rc;
+    }
+    return transferred;
+#endif  /*USE_USB_VSC*/
+}
+
+int usbPlatformWriteTransfer(void *fdKey, void *data, int size)
+{
+#ifndef USE_USB_VSC
+    return usbPlatformWrite(fdKey, data, size);
+#else
+    void* tmpUsbHandle = NULL;
+    if(getPlatformDeviceFdFromKey(fdKey, &tmpUsbHandle)){
+        mvLog(MVLOG_FATAL, "Cannot find file descriptor by key: %" PRIxPTR, (uintptr_t) fdKey);
+        return -1;
+    }
+    libusb_device_handle* usbHandle = (libusb_device_handle*) tmpUsbHandle;
+
+    int rc = usb_write(usbHandle, data, size);
+    if(rc != LIBUSB_SUCCESS) {
+        return rc;
+    }
+    // A short packet ends the transfer, one of whole packets needs a zero length one
+    int maxPacketSize = libusb_get_max_packet_size(libusb_get_device(usbHandle), USB_ENDPOINT_OUT);
+    if(maxPacketSize > 0 && size % maxPacketSize == 0) {
+        int transferred = 0;
+        rc = libusb_bulk_transfer(usbHandle, USB_ENDPOINT_OUT, (unsigned char *)data, 0, &transferred, XLINK_USB_DATA_TIMEOUT);
+    }
+    return rc;
+#endif  /*USE_USB_VSC*/
+}
+
 #ifdef _WIN32
 #include <initguid.h>
 #include <usbiodef.h>
@@ -53,6 +53,15 @@ int usbPlatformBootFirmware(const deviceDesc_t* deviceDesc, const char* firmware
 
 int usbPlatformRead(void *fd, void *data, int size);
 int usbPlatformWrite(void *fd, void *data, int size);
+// Reads one transfer, as the remote ended it, up to capacity bytes. Returns its size
+int usbPlatformReadTransfer(void *fd, void *data, int capacity);
+// Writes size bytes as one transfer, ended even if they fill whole packets
+int usbPlatformWriteTransfer(void *fd, void *data, int size);
+
+// usbfs DMA memory, so transfers skip the kernel's bounce buffer. NULL if not available
+void* usbPlatformAllocateData(void *fd, uint32_t size);
+// Returns 0 if data came from usbPlatformAllocateData and is freed now, -1 otherwise
+int usbPlatformDeallocateData(void *data);
 
 #else
 
@@ -66,6 +75,11 @@ static inline int usbPlatformBootFirmware(const deviceDesc_t* deviceDesc, const
 
 static inline int usbPlatformRead(void *fd, void *data, int size) { return -1; }
 static inline int usbPlatformWrite(void *fd, void *data, int size) { return -1; }
+static inline int usbPlatformReadTransfer(void *fd, void *data, int capacity) { return -1; }
+static inline int usbPlatformWriteTransfer(void *fd, void *data, int size) { return -1; }
+
+static inline void* usbPlatformAllocateData(void *fd, uint32_t size) { (void)fd; (void)size; return NULL; }
+static inline int usbPlatformDeallocateData(void *data) { (void)data; return -1; }
 
 static inline xLinkPlatformErrorCode_t getUSBDevices(const deviceDesc_t in_deviceRequirements,
                                                      deviceDesc_t* out_foundDevices, int sizeFoundDevices,
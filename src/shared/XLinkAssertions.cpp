@@ -7,3 +7,6 @@ static_assert(offsetof(xLinkEventHeader_t, streamName) == 8, "Offset to streamNa
 static_assert(offsetof(xLinkEventHeader_t, tnsec) == 60, "Offset to tnsec is not 60");
 static_assert(offsetof(xLinkEventHeader_t, tsecLsb) == 64, "Offset to tsecLsb is not 64");
 static_assert(offsetof(xLinkEventHeader_t, tsecMsb) == 68, "Offset to tsecMsb is not 68");
+static_assert(sizeof(xLinkCompactEventHeader_t) == 24, "Compact header size is not 24");
+static_assert(offsetof(xLinkCompactEventHeader_t, timeNs) == 16, "Offset to timeNs is not 16");
+static_assert(sizeof(XLinkCapabilities_t) <= MAX_STREAM_NAME_LENGTH, "Capabilities don't fit a ping header");
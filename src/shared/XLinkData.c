@@ -16,6 +16,8 @@
 #include "XLinkMacros.h"
 #include "XLinkPrivateFields.h"
 #include "XLinkPlatform.h"
+#include "XLinkAtomic.h"
+#include "XLinkProbes.h"
 
 #ifdef MVLOG_UNIT_NAME
 #undef MVLOG_UNIT_NAME
@@ -38,6 +40,8 @@ static XLinkError_t addEvent(xLinkEvent_t *event, unsigned int timeoutMs);
 static XLinkError_t addEventWithPerf(xLinkEvent_t *event, float* opTime, unsigned int timeoutMs);
 static XLinkError_t addEventWithPerfTimeout(xLinkEvent_t *event, float* opTime, unsigned int msTimeout);
 static XLinkError_t getLinkByStreamId(streamId_t streamId, xLinkDesc_t** out_link);
+static void writeDataAsyncServed(xLinkEvent_t* event);
+static void addCallLatency(xLinkDesc_t* link, streamId_t streamId, float opTime);
 
 // ------------------------------------
 // Helpers declaration. End.
@@ -64,9 +68,11 @@ streamId_t XLinkOpenStream(linkId_t id, const char* name, int stream_write_size)
         mv_strncpy(event.header.streamName, MAX_STREAM_NAME_LENGTH,
                    name, MAX_STREAM_NAME_LENGTH - 1);
 
-        DispatcherAddEvent(EVENT_LOCAL, &event);
+        xLinkEventCompletion_t completion;
+        XLINK_RET_ERR_IF(DispatcherAddEvent(EVENT_LOCAL, &event, &completion) == NULL,
+            INVALID_STREAM_ID);
         XLINK_RET_ERR_IF(
-            DispatcherWaitEventComplete(&link->deviceHandle, XLINK_NO_RW_TIMEOUT),
+            DispatcherWaitEventComplete(&link->deviceHandle, &completion, XLINK_NO_RW_TIMEOUT),
             INVALID_STREAM_ID);
 
 #ifndef __DEVICE__
@@ -97,6 +103,7 @@ streamId_t XLinkOpenStream(linkId_t id, const char* name, int stream_write_size)
     }
 #endif
 
+    XLINK_PROBE3(stream_open, id, streamId, stream_write_size);
     COMBINE_IDS(streamId, id);
     return streamId;
 }
@@ -115,6 +122,7 @@ XLinkError_t XLinkCloseStream(streamId_t const streamId)
         0, NULL, link->deviceHandle);
 
     XLINK_RET_IF(addEvent(&event, XLINK_NO_RW_TIMEOUT));
+    XLINK_PROBE2(stream_close, link->id, streamIdOnly);
     return X_LINK_SUCCESS;
 }
 
@@ -139,7 +147,44 @@ XLinkError_t XLinkWriteData(streamId_t const streamId, const uint8_t* buffer,
         glHandler->profilingData.totalWriteTime += opTime;
     }
     link->profilingData.totalWriteBytes += size;
-    link->profilingData.totalWriteTime += size;
+    link->profilingData.totalWriteTime += opTime;
+    addCallLatency(link, streamIdOnly, opTime);
+
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkWriteDataAsync(streamId_t const streamId, const uint8_t* buffer, int size,
+                                 XLinkWriteCallback_t callback, void* userData)
+{
+    XLINK_RET_IF(buffer == NULL);
+    XLINK_RET_IF(callback == NULL);
+
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    // writes in flight queue up on the remote as well, bound them by the smaller side
+    uint32_t eventsPerQueue = link->eventsPerQueue;
+    if (link->peer.eventsPerQueue && link->peer.eventsPerQueue < eventsPerQueue) {
+        eventsPerQueue = link->peer.eventsPerQueue;
+    }
+    if (XLink_atomic_fetch_add(&link->asyncWrites, 1) >= eventsPerQueue / 2) {
+        XLink_atomic_fetch_add(&link->asyncWrites, (uint32_t)-1);
+        return X_LINK_OUT_OF_MEMORY;
+    }
+
+    xLinkEvent_t event = {0};
+    XLINK_INIT_EVENT(event, streamIdOnly, XLINK_WRITE_REQ,
+        size, (void*)buffer, link->deviceHandle);
+    event.writeCallback = callback;
+    event.writeCallbackData = userData;
+
+    if (DispatcherAddEventAsync(&event, writeDataAsyncServed) == NULL) {
+        XLink_atomic_fetch_add(&link->asyncWrites, (uint32_t)-1);
+        mvLog(MVLOG_ERROR, "Dispatcher failed on adding event. type: %s, stream id: %u\n",
+            TypeToStr(event.header.type), event.header.streamId);
+        return X_LINK_ERROR;
+    }
 
     return X_LINK_SUCCESS;
 }
@@ -170,6 +215,7 @@ XLinkError_t XLinkReadData(streamId_t const streamId, streamPacketDesc_t** packe
     }
     link->profilingData.totalReadBytes += (*packet)->length;
     link->profilingData.totalReadTime += opTime;
+    addCallLatency(link, streamIdOnly, opTime);
 
 
     return X_LINK_SUCCESS;
@@ -198,6 +244,7 @@ XLinkError_t XLinkWriteDataWithTimeout(streamId_t const streamId, const uint8_t*
     }
     link->profilingData.totalWriteBytes += size;
     link->profilingData.totalWriteTime += opTime;
+    addCallLatency(link, streamIdOnly, opTime);
 
     return X_LINK_SUCCESS;
 }
@@ -228,6 +275,50 @@ XLinkError_t XLinkReadDataWithTimeout(streamId_t streamId, streamPacketDesc_t**
     }
     link->profilingData.totalReadBytes += (*packet)->length;
     link->profilingData.totalReadTime += opTime;
+    addCallLatency(link, streamIdOnly, opTime);
+
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkReadDataBatch(streamId_t const streamId, streamPacketDesc_t** packets,
+                                uint32_t maxCount, uint32_t* count, unsigned int timeoutMs)
+{
+    XLINK_RET_IF(packets == NULL);
+    XLINK_RET_IF(count == NULL);
+    XLINK_RET_IF(maxCount == 0);
+    *count = 0;
+
+    float opTime = 0.0f;
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    xLinkEvent_t event = {0};
+    XLINK_INIT_EVENT(event, streamIdOnly, XLINK_READ_REQ,
+        0, (void*)packets, link->deviceHandle);
+    event.packetCount = maxCount > XLINK_MAX_PACKETS_PER_STREAM ? XLINK_MAX_PACKETS_PER_STREAM : maxCount;
+
+    if (timeoutMs == XLINK_NO_RW_TIMEOUT) {
+        XLINK_RET_IF(addEventWithPerf(&event, &opTime, XLINK_NO_RW_TIMEOUT));
+    } else {
+        const XLinkError_t rc = addEventWithPerfTimeout(&event, &opTime, timeoutMs);
+        if(rc == X_LINK_TIMEOUT) return rc;
+        else XLINK_RET_IF(rc);
+    }
+
+    uint32_t totalLength = 0;
+    for (uint32_t i = 0; i < event.packetCount; i++) {
+        totalLength += packets[i]->length;
+    }
+    *count = event.packetCount;
+
+    if( glHandler->profEnable) {
+        glHandler->profilingData.totalReadBytes += totalLength;
+        glHandler->profilingData.totalReadTime += opTime;
+    }
+    link->profilingData.totalReadBytes += totalLength;
+    link->profilingData.totalReadTime += opTime;
+    addCallLatency(link, streamIdOnly, opTime);
 
     return X_LINK_SUCCESS;
 }
@@ -264,6 +355,7 @@ XLinkError_t XLinkReadMoveData(streamId_t const streamId, streamPacketDesc_t* co
     }
     link->profilingData.totalReadBytes += packet->length;
     link->profilingData.totalReadTime += opTime;
+    addCallLatency(link, streamIdOnly, opTime);
 
 
     const XLinkError_t retVal = XLinkReleaseData(streamId);
@@ -311,6 +403,7 @@ XLinkError_t XLinkReadMoveDataWithTimeout(streamId_t const streamId, streamPacke
     }
     link->profilingData.totalReadBytes += packet->length;
     link->profilingData.totalReadTime += opTime;
+    addCallLatency(link, streamIdOnly, opTime);
 
     const XLinkError_t retVal = XLinkReleaseData(streamId);
     if (retVal != X_LINK_SUCCESS) {
@@ -341,6 +434,27 @@ XLinkError_t XLinkReleaseData(streamId_t const streamId)
     return X_LINK_SUCCESS;
 }
 
+XLinkError_t XLinkReleaseDataBatch(streamId_t const streamId, uint32_t count)
+{
+    XLINK_RET_IF(count == 0);
+    XLINK_RET_IF(count > XLINK_MAX_PACKETS_PER_STREAM);
+
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    // filled with the sizes of the released packets by the dispatcher
+    uint32_t releasedSizes[XLINK_MAX_PACKETS_PER_STREAM];
+    xLinkEvent_t event = {0};
+    XLINK_INIT_EVENT(event, streamIdOnly, XLINK_READ_REL_REQ,
+        0, (void*)releasedSizes, link->deviceHandle);
+    event.packetCount = count;
+
+    XLINK_RET_IF(addEvent(&event, XLINK_NO_RW_TIMEOUT));
+
+    return X_LINK_SUCCESS;
+}
+
 XLinkError_t XLinkReleaseSpecificData(streamId_t streamId, streamPacketDesc_t* packetDesc)
 {
     xLinkDesc_t* link = NULL;
@@ -356,6 +470,73 @@ XLinkError_t XLinkReleaseSpecificData(streamId_t streamId, streamPacketDesc_t* p
     return X_LINK_SUCCESS;
 }
 
+XLinkError_t XLinkRegisterReadBuffers(streamId_t const streamId, void* const* buffers, uint32_t count, uint32_t size)
+{
+    XLINK_RET_IF(count > XLINK_MAX_PACKETS_PER_STREAM);
+    XLINK_RET_IF(count && (buffers == NULL || size == 0));
+
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    streamDesc_t* stream =
+        getStreamById(link->deviceHandle.xLinkFD, streamIdOnly);
+    XLINK_RET_IF(stream == NULL);
+
+    XLinkError_t rc = X_LINK_SUCCESS;
+    if (stream->readBuffersFree != XLINK_READ_BUFFERS_MASK(stream->readBuffersCount)) {
+        mvLog(MVLOG_ERROR, "Stream %u still holds packets in registered buffers\n", streamIdOnly);
+        rc = X_LINK_ERROR;
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            stream->readBuffers[i] = buffers[i];
+        }
+        stream->readBuffersCount = count;
+        stream->readBufferSize = count ? size : 0;
+        stream->readBuffersFree = XLINK_READ_BUFFERS_MASK(count);
+    }
+
+    releaseStream(stream);
+    return rc;
+}
+
+XLinkError_t XLinkGetBufferPoolStats(streamId_t const streamId, XLinkBufferPoolStats_t* stats)
+{
+    XLINK_RET_IF(stats == NULL);
+
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    streamDesc_t* stream =
+        getStreamById(link->deviceHandle.xLinkFD, streamIdOnly);
+    XLINK_RET_IF(stream == NULL);
+
+    stats->hits = stream->pool.hits;
+    stats->misses = stream->pool.misses;
+    stats->cachedBuffers = stream->pool.count;
+    stats->cachedBytes = stream->pool.bytes;
+
+    releaseStream(stream);
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkGetStreamStats(streamId_t const streamId, XLinkStreamStats_t* stats)
+{
+    XLINK_RET_IF(stats == NULL);
+
+    xLinkDesc_t* link = NULL;
+    XLINK_RET_IF(getLinkByStreamId(streamId, &link));
+    streamId_t streamIdOnly = EXTRACT_STREAM_ID(streamId);
+
+    // not taking the stream, so a backed up stream can be inspected without waiting on it
+    streamDesc_t* stream = peekStreamById(link->deviceHandle.xLinkFD, streamIdOnly);
+    XLINK_RET_IF(stream == NULL);
+
+    XLinkStreamGetStats(stream, stats);
+    return X_LINK_SUCCESS;
+}
+
 XLinkError_t XLinkGetFillLevel(streamId_t const streamId, int isRemote, int* fillLevel)
 {
     xLinkDesc_t* link = NULL;
@@ -421,7 +602,8 @@ XLinkError_t addEvent(xLinkEvent_t *event, unsigned int timeoutMs)
 {
     ASSERT_XLINK(event);
 
-    xLinkEvent_t* ev = DispatcherAddEvent(EVENT_LOCAL, event);
+    xLinkEventCompletion_t completion;
+    xLinkEvent_t* ev = DispatcherAddEvent(EVENT_LOCAL, event, &completion);
     if(ev == NULL) {
         mvLog(MVLOG_ERROR, "Dispatcher failed on adding event. type: %s, id: %d, stream name: %s\n",
             TypeToStr(event->header.type), event->header.id, event->header.streamName);
@@ -433,7 +615,7 @@ XLinkError_t addEvent(xLinkEvent_t *event, unsigned int timeoutMs)
         xLinkDesc_t* link;
         getLinkByStreamId(event->header.streamId, &link);
 
-        if (DispatcherWaitEventComplete(&event->deviceHandle, timeoutMs))  // timeout reached
+        if (DispatcherWaitEventComplete(&event->deviceHandle, &completion, timeoutMs))  // timeout reached
         {
             streamDesc_t* stream = getStreamById(event->deviceHandle.xLinkFD,
                                                  event->header.streamId);
@@ -454,7 +636,7 @@ XLinkError_t addEvent(xLinkEvent_t *event, unsigned int timeoutMs)
     }
     else  // No timeout
     {
-        if (DispatcherWaitEventComplete(&event->deviceHandle, timeoutMs))
+        if (DispatcherWaitEventComplete(&event->deviceHandle, &completion, timeoutMs))
         {
             return X_LINK_TIMEOUT;
         }
@@ -482,18 +664,28 @@ XLinkError_t addEventWithPerf(xLinkEvent_t *event, float* opTime, unsigned int t
     return X_LINK_SUCCESS;
 }
 
-XLinkError_t addEventTimeout(xLinkEvent_t *event, struct timespec abstime)
+XLinkError_t addEventTimeout(xLinkEvent_t *event, unsigned int timeoutMs)
 {
     ASSERT_XLINK(event);
 
-    xLinkEvent_t* ev = DispatcherAddEvent(EVENT_LOCAL, event);
+    xLinkEventCompletion_t completion;
+    xLinkEvent_t* ev = DispatcherAddEvent(EVENT_LOCAL, event, &completion);
     if(ev == NULL) {
         mvLog(MVLOG_ERROR, "Dispatcher failed on adding event. type: %s, id: %d, stream name: %s\n",
             TypeToStr(event->header.type), event->header.id, event->header.streamName);
         return X_LINK_ERROR;
     }
 
-    if (DispatcherWaitEventCompleteTimeout(&event->deviceHandle, abstime)) {
+    int rc;
+    if (event->header.type == XLINK_READ_REQ) {
+        // The request is dropped together with giving up on it, so no packet
+        // can be taken for a read which already returned
+        rc = DispatcherWaitEventCompleteOrWithdraw(&event->deviceHandle, &completion,
+                                                   timeoutMs, event);
+    } else {
+        rc = DispatcherWaitEventCompleteTimeout(&event->deviceHandle, &completion, timeoutMs);
+    }
+    if (rc) {
         return X_LINK_TIMEOUT;
     }
 
@@ -511,15 +703,7 @@ XLinkError_t addEventWithPerfTimeout(xLinkEvent_t *event, float* opTime, unsigne
     struct timespec start, end;
     clock_gettime(CLOCK_REALTIME, &start);
 
-    struct timespec absTimeout = start;
-    int64_t sec = msTimeout / 1000;
-    absTimeout.tv_sec += sec;
-    absTimeout.tv_nsec += (long)((msTimeout - (sec * 1000)) * 1000000);
-    int64_t secOver = absTimeout.tv_nsec / 1000000000;
-    absTimeout.tv_nsec -= (long)(secOver * 1000000000);
-    absTimeout.tv_sec += secOver;
-
-    int rc = addEventTimeout(event, absTimeout);
+    int rc = addEventTimeout(event, msTimeout);
     if(rc != X_LINK_SUCCESS) return rc;
 
     clock_gettime(CLOCK_REALTIME, &end);
@@ -528,6 +712,37 @@ XLinkError_t addEventWithPerfTimeout(xLinkEvent_t *event, float* opTime, unsigne
     return X_LINK_SUCCESS;
 }
 
+static void writeDataAsyncServed(xLinkEvent_t* event)
+{
+    int size = (int)event->header.size;
+    XLinkError_t status = X_LINK_SUCCESS;
+    if (event->header.flags.bitField.ack != 1) {
+        status = X_LINK_COMMUNICATION_FAIL;
+    }
+
+    xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+    if (link) {
+        XLink_atomic_fetch_add(&link->asyncWrites, (uint32_t)-1);
+        if (status == X_LINK_SUCCESS) {
+            if (glHandler->profEnable) {
+                glHandler->profilingData.totalWriteBytes += size;
+            }
+            link->profilingData.totalWriteBytes += size;
+        }
+    }
+
+    event->writeCallback((const uint8_t*)event->data, size, status, event->writeCallbackData);
+}
+
+static void addCallLatency(xLinkDesc_t* link, streamId_t streamId, float opTime)
+{
+    streamDesc_t* stream = peekStreamById(link->deviceHandle.xLinkFD, streamId);
+    if (stream) {
+        XLinkStreamRecordLatency(stream->stats.callLatency,
+                                 opTime > 0 ? (uint64_t)(opTime * 1000000.0f) : 0);
+    }
+}
+
 static XLinkError_t getLinkByStreamId(streamId_t streamId, xLinkDesc_t** out_link) {
     ASSERT_XLINK(out_link != NULL);
 
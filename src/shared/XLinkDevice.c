@@ -14,6 +14,8 @@
 #include "XLinkPlatform.h"
 #include "XLinkPrivateFields.h"
 #include "XLinkDispatcherImpl.h"
+#include "XLinkReactor.h"
+#include "XLinkProbes.h"
 
 #ifdef MVLOG_UNIT_NAME
 #undef MVLOG_UNIT_NAME
@@ -85,6 +87,10 @@ XLinkError_t XLinkInitialize(XLinkGlobalHandler_t* globalHandler)
 #ifdef __DEVICE__
     mvLogLevelSet(MVLOG_FATAL);
     mvLogDefaultLevelSet(MVLOG_FATAL);
+#elif defined(XLINK_LOG_ASYNC)
+    if (mvLogSetAsync(1)) {
+        mvLog(MVLOG_WARN, "Can't start the log thread, logging synchronously\n");
+    }
 #endif
 
     ASSERT_XLINK(XLINK_MAX_STREAMS <= MAX_POOLS_ALLOC);
@@ -118,6 +124,10 @@ XLinkError_t XLinkInitialize(XLinkGlobalHandler_t* globalHandler)
     controlFunctionTbl.remoteGetResponse = &dispatcherRemoteEventGetResponse;
     controlFunctionTbl.closeLink         = &dispatcherCloseLink;
     controlFunctionTbl.closeDeviceFd     = &dispatcherCloseDeviceFd;
+    controlFunctionTbl.flushDeferred     = &dispatcherFlushDeferred;
+    controlFunctionTbl.flushSends        = &dispatcherFlushSends;
+    controlFunctionTbl.eventReceivePartial = &dispatcherEventReceivePartial;
+    controlFunctionTbl.eventReceiveCancel  = &dispatcherEventReceiveCancel;
 
     if (DispatcherInitialize(&controlFunctionTbl)) {
         mvLog(MVLOG_ERROR, "Condition failed: DispatcherInitialize(&controlFunctionTbl)");
@@ -163,6 +173,7 @@ XLinkError_t XLinkInitialize(XLinkGlobalHandler_t* globalHandler)
 
     while(((sem_wait(&pingSem) == -1) && errno == EINTR)
         continue;
+    XLINK_PROBE3(link_up, link->id, link->deviceHandle.xLinkFD, link->deviceHandle.protocol);
 
 #endif
 
@@ -226,6 +237,11 @@ XLinkError_t XLinkSearchForDevices(const deviceDesc_t in_deviceRequirements,
 
 //Called only from app - per device
 XLinkError_t XLinkConnect(XLinkHandler_t* handler)
+{
+    return XLinkConnectWithLimits(handler, NULL);
+}
+
+XLinkError_t XLinkConnectWithLimits(XLinkHandler_t* handler, const XLinkLinkLimits_t* limits)
 {
     XLINK_RET_IF(handler == NULL);
     if (strnlen(handler->devicePath, MAX_PATH_LENGTH) < 2) {
@@ -237,6 +253,20 @@ XLinkError_t XLinkConnect(XLinkHandler_t* handler)
     XLINK_RET_IF(link == NULL);
     mvLog(MVLOG_DEBUG,"%s() device name %s glHandler %p protocol %d\n", __func__, handler->devicePath, glHandler, handler->protocol);
 
+    if (limits) {
+        if (limits->packetsPerStream) {
+            link->packetsPerStream = limits->packetsPerStream;
+        }
+        if (limits->eventsPerQueue) {
+            // submission positions wrap around at 2^32, which a power of two divides
+            uint32_t eventsPerQueue = 2;
+            while (eventsPerQueue < limits->eventsPerQueue && eventsPerQueue < (1u << 16)) {
+                eventsPerQueue <<= 1;
+            }
+            link->eventsPerQueue = eventsPerQueue;
+        }
+    }
+
     link->deviceHandle.protocol = handler->protocol;
     int connectStatus = XLinkPlatformConnect(handler->devicePath2, handler->devicePath,
                                              link->deviceHandle.protocol, &link->deviceHandle.xLinkFD);
@@ -260,15 +290,17 @@ XLinkError_t XLinkConnect(XLinkHandler_t* handler)
     xLinkEvent_t event = {0};
 
     event.header.type = XLINK_PING_REQ;
+    XLinkHandshakeWrite(link, &event.header);
     event.deviceHandle = link->deviceHandle;
-    DispatcherAddEvent(EVENT_LOCAL, &event);
-
-    if (DispatcherWaitEventComplete(&link->deviceHandle, XLINK_NO_RW_TIMEOUT)) {
+    xLinkEventCompletion_t completion;
+    if (DispatcherAddEvent(EVENT_LOCAL, &event, &completion) == NULL ||
+        DispatcherWaitEventComplete(&link->deviceHandle, &completion, XLINK_NO_RW_TIMEOUT)) {
         DispatcherClean(&link->deviceHandle);
         return X_LINK_TIMEOUT;
     }
 
     link->peerState = XLINK_UP;
+    XLINK_PROBE3(link_up, link->id, link->deviceHandle.xLinkFD, link->deviceHandle.protocol);
     #if (!defined(_WIN32) && !defined(_WIN64) )
         link->usbConnSpeed = get_usb_speed();
         mv_strcpy(link->mxSerialId, XLINK_MAX_MX_ID_SIZE, get_mx_serial());
@@ -331,13 +363,23 @@ XLinkError_t XLinkResetRemote(linkId_t id)
     event.header.type = XLINK_RESET_REQ;
     event.deviceHandle = link->deviceHandle;
     mvLog(MVLOG_DEBUG, "sending reset remote event\n");
-    DispatcherAddEvent(EVENT_LOCAL, &event);
-    XLINK_RET_ERR_IF(DispatcherWaitEventComplete(&link->deviceHandle, XLINK_NO_RW_TIMEOUT),
-        X_LINK_TIMEOUT);
+    // The reset completes this event before closing the link, which destroys
+    // dispatcherClosedSem. Hold it, so it outlives our wait on it.
+    XLINK_RET_ERR_IF(XLink_sem_inc(&link->dispatcherClosedSem), X_LINK_ERROR);
+    xLinkEventCompletion_t completion;
+    if (DispatcherAddEvent(EVENT_LOCAL, &event, &completion) == NULL) {
+        XLink_sem_dec(&link->dispatcherClosedSem);
+        return X_LINK_ERROR;
+    }
+    if (DispatcherWaitEventComplete(&link->deviceHandle, &completion, XLINK_NO_RW_TIMEOUT)) {
+        XLink_sem_dec(&link->dispatcherClosedSem);
+        return X_LINK_TIMEOUT;
+    }
 
     int rc;
     while(((rc = XLink_sem_wait(&link->dispatcherClosedSem)) == -1) && errno == EINTR)
         continue;
+    XLink_sem_dec(&link->dispatcherClosedSem);
     if(rc) {
         mvLog(MVLOG_ERROR,"can't wait dispatcherClosedSem\n");
         return X_LINK_ERROR;
@@ -363,34 +405,35 @@ XLinkError_t XLinkResetRemoteTimeout(linkId_t id, int timeoutMs)
     event.deviceHandle = link->deviceHandle;
     mvLog(MVLOG_DEBUG, "sending reset remote event\n");
 
-    struct timespec start;
-    clock_gettime(CLOCK_REALTIME, &start);
-
-    struct timespec absTimeout = start;
-    int64_t sec = timeoutMs / 1000;
-    absTimeout.tv_sec += sec;
-    absTimeout.tv_nsec += (long)((timeoutMs - (sec * 1000)) * 1000000);
-    int64_t secOver = absTimeout.tv_nsec / 1000000000;
-    absTimeout.tv_nsec -= (long)(secOver * 1000000000);
-    absTimeout.tv_sec += secOver;
-
-    xLinkEvent_t* ev = DispatcherAddEvent(EVENT_LOCAL, &event);
+    // see XLinkResetRemote
+    XLINK_RET_ERR_IF(XLink_sem_inc(&link->dispatcherClosedSem), X_LINK_ERROR);
+    xLinkEventCompletion_t completion;
+    xLinkEvent_t* ev = DispatcherAddEvent(EVENT_LOCAL, &event, &completion);
     if(ev == NULL) {
         mvLog(MVLOG_ERROR, "Dispatcher failed on adding event. type: %s, id: %d, stream name: %s\n",
             TypeToStr(event.header.type), event.header.id, event.header.streamName);
+        XLink_sem_dec(&link->dispatcherClosedSem);
         return X_LINK_ERROR;
     }
 
-    XLinkError_t ret = DispatcherWaitEventCompleteTimeout(&link->deviceHandle, absTimeout);
+    XLinkError_t ret = DispatcherWaitEventCompleteTimeout(&link->deviceHandle, &completion,
+                                                          timeoutMs < 0 ? 0 : (unsigned int)timeoutMs);
 
+    int rc;
     if(ret != X_LINK_SUCCESS){
+        // Not held meanwhile, the reset may be waiting for it under reset_mutex
+        XLink_sem_dec(&link->dispatcherClosedSem);
         // Closing device link unblocks any blocked events
         // Afterwards the dispatcher can properly cleanup in its own thread
         DispatcherDeviceFdDown(&link->deviceHandle);
+        // Wait for dispatcher to be closed
+        rc = XLink_sem_wait(&link->dispatcherClosedSem);
+    } else {
+        // Wait for dispatcher to be closed
+        rc = XLink_sem_wait(&link->dispatcherClosedSem);
+        XLink_sem_dec(&link->dispatcherClosedSem);
     }
-
-    // Wait for dispatcher to be closed
-    if(XLink_sem_wait(&link->dispatcherClosedSem)) {
+    if(rc) {
         mvLog(MVLOG_ERROR,"can't wait dispatcherClosedSem\n");
         return X_LINK_ERROR;
     }
@@ -501,6 +544,57 @@ XLinkError_t XLinkGetProfilingData(linkId_t id, XLinkProf_t* prof)
     return X_LINK_SUCCESS;
 }
 
+XLinkError_t XLinkGetPeerCapabilities(linkId_t id, XLinkCapabilities_t* caps)
+{
+    XLINK_RET_IF(caps == NULL);
+    xLinkDesc_t* link = getLinkById(id);
+    XLINK_RET_IF(link == NULL);
+
+    *caps = link->peer;
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkSetReleaseCoalescing(linkId_t id, uint32_t maxPackets, unsigned int maxDelayMs)
+{
+    XLINK_RET_IF(maxPackets > XLINK_MAX_PACKETS_PER_STREAM);
+    xLinkDesc_t* link = getLinkById(id);
+    XLINK_RET_IF(link == NULL);
+    // a remote without capabilities (version 0) can't take them either
+    if (maxPackets > 1 && !(link->peer.features & XLINK_FEATURE_RELEASE_COALESCING)) {
+        mvLog(MVLOG_ERROR, "The remote doesn't take coalesced releases");
+        return X_LINK_ERROR;
+    }
+
+    // held back releases are flushed by the dispatcher once coalescing gets disabled
+    link->releaseCoalesceDelayMs = maxDelayMs;
+    link->releaseCoalescePackets = maxPackets;
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkSetTcpReactorThreads(unsigned int count)
+{
+    XLINK_RET_IF(count > XLINK_REACTOR_MAX_THREADS);
+    return XLinkReactorSetThreads(count) ? X_LINK_ERROR : X_LINK_SUCCESS;
+}
+
+XLinkError_t XLinkSetSchedulerThreads(unsigned int count)
+{
+    XLINK_RET_IF(count > XLINK_MAX_SCHEDULER_THREADS);
+    return DispatcherSetSchedulerThreads(count);
+}
+
+XLinkError_t XLinkTraceDump(linkId_t id, const char* path)
+{
+    XLINK_RET_IF(path == NULL);
+    xLinkDesc_t* link = getLinkById(id);
+    XLINK_RET_IF(link == NULL);
+
+    if (XLinkTraceWriteChrome(&link->trace, id, path)) {
+        return X_LINK_ERROR;
+    }
+    return X_LINK_SUCCESS;
+}
+
 UsbSpeed_t XLinkGetUSBSpeed(linkId_t id){
     xLinkDesc_t* link = getLinkById(id);
     return link->usbConnSpeed;
@@ -585,6 +679,15 @@ static xLinkDesc_t* getNextAvailableLink() {
     }
 
     link->id = id;
+    link->releaseCoalescePackets = 0;
+    link->releaseCoalesceDelayMs = 0;
+    link->asyncWrites = 0;
+    link->packetsPerStream = XLINK_MAX_PACKETS_PER_STREAM;
+    link->eventsPerQueue = MAX_EVENTS;
+    link->compactHeaderRx = 0;
+    link->compactHeaderTx = 0;
+    memset(&link->peer, 0, sizeof(link->peer));
+    XLinkTraceReset(&link->trace);
     XLINK_RET_ERR_IF(pthread_mutex_unlock(&availableXLinksMutex) != 0, NULL);
 
     return link;
@@ -32,11 +32,16 @@
 #endif
 
 #include "XLinkDispatcher.h"
+#include "XLinkReactor.h"
 #include "XLinkMacros.h"
 #include "XLinkPrivateDefines.h"
 #include "XLinkPrivateFields.h"
+#include "XLinkPlatform.h"
 #include "XLink.h"
 #include "XLinkErrorUtils.h"
+#include "XLinkAtomic.h"
+#include "XLinkTime.h"
+#include "XLinkProbes.h"
 
 #define MVLOG_UNIT_NAME xLink
 #include "XLinkLog.h"
@@ -50,57 +55,143 @@ typedef enum {
     EVENT_PENDING,
     EVENT_BLOCKED,
     EVENT_READY,
+    EVENT_COMPLETED, // served, its callback not called yet
     EVENT_SERVED,
 } xLinkEventState_t;
 
+/**
+ * @brief Scheduling state of a link served by the shared scheduler workers
+ */
+typedef enum {
+    LINK_IDLE,
+    LINK_QUEUED,
+    LINK_RUNNING,
+    LINK_RUNNING_NOTIFIED, // work arrived while a worker serves the link
+    LINK_CLOSED,
+} xLinkRunState_t;
+
+struct xLinkEventPriv_t;
+struct eventQueueHandler_t;
+
+typedef struct {
+    struct xLinkEventPriv_t* head;
+    struct xLinkEventPriv_t* tail;
+} eventList_t;
+
 typedef struct xLinkEventPriv_t {
     xLinkEvent_t packet;
     xLinkEvent_t *retEv;
     xLinkEventState_t isServed;
     xLinkEventOrigin_t origin;
+    uint32_t sequence; // order of arrival in the queue, wraps around
+    uint32_t withdrawn; // its waiter gave up while it was being processed
     XLink_sem_t* sem;
+    xLinkEventCallback_t callback; // asynchronous local event, called once served
     void* data;
+
+    struct eventQueueHandler_t* queue;
+    eventList_t* list; // list the event is linked into, NULL while it is being processed
+    struct xLinkEventPriv_t* next;
 } xLinkEventPriv_t;
 
-typedef struct {
-    XLink_sem_t sem;
-    pthread_t threadId;
-} localSem_t;
+#define EVENT_INDEX_SIZE MAX_EVENTS
+// events a shared reader thread takes off one link before serving the next
+#define XLINK_REACTOR_EVENTS_PER_WAKEUP 16
+// events a shared scheduler worker serves on one link before taking the next
+#define XLINK_POOL_EVENTS_PER_TURN 16
+
+/**
+ * @brief Event slots, each linked into the list matching its state
+ */
+typedef struct eventQueueHandler_t{
+    eventList_t free;                       // EVENT_SERVED
+    eventList_t allocated;                  // EVENT_ALLOCATED, in order of arrival
+    eventList_t ready;                      // EVENT_READY, in order of unblocking
+    eventList_t completed;                  // EVENT_COMPLETED, in order of serving
+    eventList_t pending[EVENT_INDEX_SIZE];  // EVENT_PENDING, indexed by id
+    eventList_t blocked[EVENT_INDEX_SIZE];  // EVENT_BLOCKED, indexed by streamId and type
+
+    xLinkEventPriv_t* q; // capacity slots, kept by the scheduler slot across links
+    uint32_t capacity;
+    uint32_t nextSequence;
+
+    xLinkTraceRing_t* trace; // of the link, NULL if it has none
+}eventQueueHandler_t;
 
-typedef struct{
-    xLinkEventPriv_t* end;
-    xLinkEventPriv_t* base;
+typedef struct {
+    volatile uint32_t sequence;
+    xLinkEvent_t packet;
+    xLinkEvent_t* retEv;
+    XLink_sem_t* sem;
+    xLinkEventCallback_t callback;
+    uint32_t withdrawn; // skipped instead of moved to lQueue
+} eventSubmission_t;
 
-    xLinkEventPriv_t* curProc;
-    xLinkEventPriv_t* cur;
-    XLINK_ALIGN_TO_BOUNDARY(64) xLinkEventPriv_t q[MAX_EVENTS];
+/**
+ * @brief Bounded lock-free queue of local events. Any API thread submits
+ *        without locking, the scheduler thread moves them into lQueue.
+ */
+typedef struct {
+    eventSubmission_t* cells; // capacity cells
+    uint32_t capacity;
+    XLINK_ALIGN_TO_BOUNDARY(64) volatile uint32_t enqueuePos;
+    XLINK_ALIGN_TO_BOUNDARY(64) uint32_t dequeuePos;
+} eventSubmitQueue_t;
 
-}eventQueueHandler_t;
 /**
  * @brief Scheduler for each device
  */
 typedef struct {
     xLinkDeviceHandle_t deviceHandle; //will be device handler
     int schedulerId;
+    linkId_t linkId; // for the tracepoints
 
     int queueProcPriority;
 
     pthread_mutex_t queueMutex;
 
-    XLink_sem_t addEventSem;
     XLink_sem_t notifyDispatcherSem;
+    volatile uint32_t dispatcherIdle; // scheduler waits on notifyDispatcherSem
+    volatile uint32_t dispatcherCleaning; // dispatcherGetNextEvent returns NULL instead of waiting
     volatile uint32_t resetXLink;
-    uint32_t semaphores;
     pthread_t xLinkThreadId;
 
+    XLink_sem_t remoteSlotSem;
+    uint32_t readerWaiting; // eventReader waits on remoteSlotSem for a free rQueue slot
+    uint32_t callbacksRunning; // a thread calls the callbacks of lQueue.completed
+
+    // Links read by the shared reader threads instead of an eventReader thread
+    uint32_t reactorActive;
+    xLinkReactorSource_t reactorSource;
+    xLinkEvent_t reactorEvent;
+    xLinkEventReceiveState_t reactorReceiveState;
+
+    // Links scheduled by the shared workers instead of a thread of their own
+    uint32_t pooled;
+    volatile uint32_t runState; // xLinkRunState_t
+    volatile uint32_t pendingStops; // parts of a closing link, worker and reader, still running
+    uint64_t deferredDueMs; // idle with deferred work due then, guarded by pool_mutex
+
     eventQueueHandler_t lQueue; //local queue
     eventQueueHandler_t rQueue; //remote queue
-    localSem_t eventSemaphores[MAXIMUM_SEMAPHORES];
+    eventSubmitQueue_t submitQueue; //local events not yet moved to lQueue
 
     uint32_t dispatcherLinkDown;
     uint32_t dispatcherDeviceFdDown;
+
+    uint64_t deferredCheckMs; // monotonic time to call flushDeferred at while busy
 } xLinkSchedulerState_t;
 
+/**
+ * @brief Reader thread kept for reuse by the links of the shared scheduler workers
+ */
+typedef struct {
+    pthread_t threadId;
+    XLink_sem_t startSem;
+    xLinkSchedulerState_t* link;
+    uint32_t busy;
+} pooledReader_t;
+
 
 // ------------------------------------
 // Data structures declaration. Begin.
@@ -118,10 +209,25 @@ int numSchedulers;
 xLinkSchedulerState_t schedulerState[MAX_SCHEDULERS];
 sem_t addSchedulerSem;
 
-static pthread_mutex_t unique_id_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile uint32_t eventIdCounter;
 static pthread_mutex_t clean_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t reset_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t num_schedulers_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Shared scheduler workers
+static pthread_mutex_t pool_config_mutex = PTHREAD_MUTEX_INITIALIZER; // thread count changes and link starts
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int poolThreadCount;
+static unsigned int poolThreadsRunning;
+static unsigned int poolLinkCount; // links using the workers, closing ones included
+static uint32_t poolStopping;
+static pthread_t poolThreads[XLINK_MAX_SCHEDULER_THREADS];
+static XLink_sem_t poolRunSem; // posted once per queued link
+static xLinkSchedulerState_t* poolRunQueue[MAX_SCHEDULERS];
+static unsigned int poolRunHead;
+static unsigned int poolRunCount;
+static pooledReader_t poolReaders[MAX_SCHEDULERS];
+static unsigned int poolReadersStarted;
 // ------------------------------------
 // Global fields declaration. End.
 // ------------------------------------
@@ -132,12 +238,6 @@ static pthread_mutex_t num_schedulers_mutex = PTHREAD_MUTEX_INITIALIZER;
 // Helpers declaration. Begin.
 // ------------------------------------
 
-//below workaround for "C2088 '==': illegal for struct" error
-static int pthread_t_compare(pthread_t a, pthread_t b);
-
-static XLink_sem_t* createSem(xLinkSchedulerState_t* curr);
-static XLink_sem_t* getSem(pthread_t threadId, xLinkSchedulerState_t *curr);
-
 #if (defined(_WIN32) || defined(_WIN64))
 static void* __cdecl eventReader(void* ctx);
 static void* __cdecl eventSchedulerRun(void* ctx);
@@ -145,9 +245,12 @@ static void* __cdecl eventSchedulerRun(void* ctx);
 static void* eventReader(void* ctx);
 static void* eventSchedulerRun(void* ctx);
 #endif
+static int reactorReadEvents(xLinkReactorSource_t* source);
+static int startReactorReading(xLinkSchedulerState_t* curr);
 
 static int isEventTypeRequest(xLinkEventPriv_t* event);
 static void postAndMarkEventServed(xLinkEventPriv_t *event);
+static void postAndMarkEventDropped(xLinkEventPriv_t *event);
 static int createUniqueID();
 static int findAvailableScheduler();
 static xLinkSchedulerState_t* findCorrespondingScheduler(void* xLinkFD);
@@ -155,8 +258,17 @@ static xLinkSchedulerState_t* findCorrespondingScheduler(void* xLinkFD);
 static int dispatcherRequestServe(xLinkEventPriv_t * event, xLinkSchedulerState_t* curr);
 static int dispatcherResponseServe(xLinkEventPriv_t * event, xLinkSchedulerState_t* curr);
 
-static inline xLinkEventPriv_t* getNextElementWithState(xLinkEventPriv_t* base, xLinkEventPriv_t* end,
-                                                        xLinkEventPriv_t* start, xLinkEventState_t state);
+static int reserveEventStorage(xLinkSchedulerState_t* curr, uint32_t capacity);
+static void initEventQueue(eventQueueHandler_t* q, xLinkEventPriv_t* events, uint32_t capacity);
+static void eventListPush(eventList_t* list, xLinkEventPriv_t* event);
+static int isSequenceBefore(uint32_t a, uint32_t b);
+static void eventListInsertBySequence(eventList_t* list, xLinkEventPriv_t* event);
+static xLinkEventPriv_t* eventListPop(eventList_t* list);
+static void eventListRemove(xLinkEventPriv_t* event);
+static eventList_t* getPendingList(eventQueueHandler_t* q, eventId_t id);
+static eventList_t* getBlockedList(eventQueueHandler_t* q, streamId_t streamId, xLinkEventType_t type);
+static void setEventState(xLinkEventPriv_t* event, xLinkEventState_t state);
+static int isEventMatching(xLinkEventPriv_t* event, eventId_t id, xLinkEventType_t type, streamId_t stream);
 
 static xLinkEventPriv_t* searchForReadyEvent(xLinkSchedulerState_t* curr);
 
@@ -165,6 +277,23 @@ static xLinkEvent_t* addNextQueueElemToProc(xLinkSchedulerState_t* curr,
                                             eventQueueHandler_t *q, xLinkEvent_t* event,
                                             XLink_sem_t* sem, xLinkEventOrigin_t o);
 
+static int submitLocalEvent(eventSubmitQueue_t* q, xLinkEvent_t* event,
+                            XLink_sem_t* sem, xLinkEventCallback_t callback);
+static void moveSubmittedEvents(xLinkSchedulerState_t* curr);
+static int detachCompletion(xLinkSchedulerState_t* curr, xLinkEventCompletion_t* completion);
+static void detachCompletionLocked(xLinkSchedulerState_t* curr, xLinkEventCompletion_t* completion);
+static int withdrawEventLocked(xLinkSchedulerState_t* curr, xLinkEventCompletion_t* completion);
+static int finishCompletion(xLinkSchedulerState_t* curr, xLinkEventCompletion_t* completion, int rc);
+static void runEventCallbacks(xLinkSchedulerState_t* curr);
+static void wakeDispatcher(xLinkSchedulerState_t* curr);
+static void waitForRemoteSlot(xLinkSchedulerState_t* curr);
+static void traceEvent(eventQueueHandler_t* q, xLinkTraceStage_t stage,
+                       xLinkEventOrigin_t origin, const xLinkEvent_t* event);
+
+static xLinkEventPriv_t* takeNextEvent(xLinkSchedulerState_t* curr);
+static unsigned int flushDeferredWork(xLinkSchedulerState_t* curr);
+static void flushHeldSends(xLinkSchedulerState_t* curr);
+static int isLinkWriter(xLinkSchedulerState_t* curr);
 static xLinkEventPriv_t* dispatcherGetNextEvent(xLinkSchedulerState_t* curr);
 
 static int dispatcherClean(xLinkSchedulerState_t* curr);
@@ -174,6 +303,24 @@ static int dispatcherDeviceFdDown(xLinkSchedulerState_t* curr);
 static void dispatcherFreeEvents(eventQueueHandler_t *queue, xLinkEventState_t state);
 
 static XLinkError_t sendEvents(xLinkSchedulerState_t* curr);
+static XLinkError_t serveEvent(xLinkSchedulerState_t* curr, xLinkEventPriv_t* event);
+
+#if (defined(_WIN32) || defined(_WIN64))
+static void* __cdecl schedulerWorkerRun(void* ctx);
+static void* __cdecl pooledReaderRun(void* ctx);
+#else
+static void* schedulerWorkerRun(void* ctx);
+static void* pooledReaderRun(void* ctx);
+#endif
+static int startPooledLink(xLinkSchedulerState_t* curr);
+static int startPooledReader(xLinkSchedulerState_t* curr);
+static void runPooledLink(xLinkSchedulerState_t* curr);
+static void scheduleLink(xLinkSchedulerState_t* curr);
+static void pushRunnableLink(xLinkSchedulerState_t* curr);
+static unsigned int scheduleDueLinks(void);
+static void finishPooledLinkPart(xLinkSchedulerState_t* curr);
+static int startPoolThreads(void);
+static void stopPoolThreads(void);
 
 // ------------------------------------
 // Helpers declaration. End.
@@ -205,8 +352,35 @@ XLinkError_t DispatcherInitialize(DispatcherControlFunctions *controlFunc) {
 
     for (int i = 0; i < MAX_SCHEDULERS; i++){
         schedulerState[i].schedulerId = -1;
+        schedulerState[i].dispatcherLinkDown = 1;
+    }
+
+    return X_LINK_SUCCESS;
+}
+
+XLinkError_t DispatcherSetSchedulerThreads(unsigned int count)
+{
+    XLINK_RET_IF(count > XLINK_MAX_SCHEDULER_THREADS);
+    XLINK_RET_ERR_IF(pthread_mutex_lock(&pool_config_mutex) != 0, X_LINK_ERROR);
+
+    if (pthread_mutex_lock(&pool_mutex) != 0) {
+        pthread_mutex_unlock(&pool_config_mutex);
+        return X_LINK_ERROR;
+    }
+    unsigned int links = poolLinkCount;
+    pthread_mutex_unlock(&pool_mutex);
+    if (links) {
+        pthread_mutex_unlock(&pool_config_mutex);
+        mvLog(MVLOG_ERROR, "Scheduler threads can't change while links use them");
+        return X_LINK_ERROR;
     }
 
+    // warm threads stay for reconnects, unless the count changes
+    if (count != poolThreadCount) {
+        stopPoolThreads();
+        poolThreadCount = count;
+    }
+    pthread_mutex_unlock(&pool_config_mutex);
     return X_LINK_SUCCESS;
 }
 
@@ -218,64 +392,97 @@ XLinkError_t DispatcherStart(xLinkDeviceHandle_t *deviceHandle)
 #endif
 
     pthread_attr_t attr;
-    int eventIdx;
+    // links connecting concurrently must not take the same scheduler slot
+    while(((sem_wait(&addSchedulerSem) == -1) && errno == EINTR))
+        continue;
     if (numSchedulers >= MAX_SCHEDULERS)
     {
         mvLog(MVLOG_ERROR,"Max number Schedulers reached!\n");
+        sem_post(&addSchedulerSem);
         return -1;
     }
     int idx = findAvailableScheduler();
     if (idx == -1) {
         mvLog(MVLOG_ERROR,"Max number Schedulers reached!\n");
+        sem_post(&addSchedulerSem);
+        return -1;
+    }
+
+    xLinkDesc_t* link = getLink(deviceHandle->xLinkFD);
+    uint32_t eventsPerQueue = link && link->eventsPerQueue ? link->eventsPerQueue : MAX_EVENTS;
+    if (reserveEventStorage(&schedulerState[idx], eventsPerQueue)) {
+        mvLog(MVLOG_ERROR,"Can't allocate %u events\n", eventsPerQueue);
+        sem_post(&addSchedulerSem);
         return -1;
     }
+    xLinkEventPriv_t* localEvents = schedulerState[idx].lQueue.q;
+    xLinkEventPriv_t* remoteEvents = schedulerState[idx].rQueue.q;
+    eventSubmission_t* submissions = schedulerState[idx].submitQueue.cells;
 
     memset(&schedulerState[idx], 0, sizeof(xLinkSchedulerState_t));
 
-    schedulerState[idx].semaphores = 0;
     schedulerState[idx].queueProcPriority = 0;
 
     schedulerState[idx].resetXLink = 0;
+    schedulerState[idx].dispatcherIdle = 0;
+    schedulerState[idx].dispatcherCleaning = 0;
     schedulerState[idx].dispatcherLinkDown = 0;
     schedulerState[idx].dispatcherDeviceFdDown = 0;
 
     schedulerState[idx].deviceHandle = *deviceHandle;
     schedulerState[idx].schedulerId = idx;
 
-    schedulerState[idx].lQueue.cur = schedulerState[idx].lQueue.q;
-    schedulerState[idx].lQueue.curProc = schedulerState[idx].lQueue.q;
-    schedulerState[idx].lQueue.base = schedulerState[idx].lQueue.q;
-    schedulerState[idx].lQueue.end = &schedulerState[idx].lQueue.q[MAX_EVENTS];
-
-    schedulerState[idx].rQueue.cur = schedulerState[idx].rQueue.q;
-    schedulerState[idx].rQueue.curProc = schedulerState[idx].rQueue.q;
-    schedulerState[idx].rQueue.base = schedulerState[idx].rQueue.q;
-    schedulerState[idx].rQueue.end = &schedulerState[idx].rQueue.q[MAX_EVENTS];
-
-    for (eventIdx = 0 ; eventIdx < MAX_EVENTS; eventIdx++)
-    {
-        schedulerState[idx].rQueue.q[eventIdx].isServed = EVENT_SERVED;
-        schedulerState[idx].lQueue.q[eventIdx].isServed = EVENT_SERVED;
+    initEventQueue(&schedulerState[idx].lQueue, localEvents, eventsPerQueue);
+    initEventQueue(&schedulerState[idx].rQueue, remoteEvents, eventsPerQueue);
+    if (link) {
+        XLink_atomic_store(&link->schedulerIndexHint, (uint32_t)idx);
     }
-
-    if (XLink_sem_init(&schedulerState[idx].addEventSem, 0, 1)) {
-        perror("Can't create semaphore\n");
-        return -1;
+    schedulerState[idx].linkId = link ? link->id : INVALID_LINK_ID;
+    schedulerState[idx].lQueue.trace = link ? &link->trace : NULL;
+    schedulerState[idx].rQueue.trace = schedulerState[idx].lQueue.trace;
+    schedulerState[idx].submitQueue.cells = submissions;
+    schedulerState[idx].submitQueue.capacity = eventsPerQueue;
+    for (uint32_t i = 0; i < eventsPerQueue; i++) {
+        submissions[i].sequence = i;
     }
+
     if (pthread_mutex_init(&(schedulerState[idx].queueMutex), NULL) != 0) {
         perror("pthread_mutex_init error");
+        sem_post(&addSchedulerSem);
         return -1;
     }
     if (XLink_sem_init(&schedulerState[idx].notifyDispatcherSem, 0, 0)) {
         perror("Can't create semaphore\n");
     }
-    localSem_t* temp = schedulerState[idx].eventSemaphores;
-    while (temp < schedulerState[idx].eventSemaphores + MAXIMUM_SEMAPHORES) {
-        XLink_sem_set_refs(&temp->sem, -1);
-        temp++;
+    if (XLink_sem_init(&schedulerState[idx].remoteSlotSem, 0, 0)) {
+        perror("Can't create semaphore\n");
+    }
+
+    if (pthread_mutex_lock(&pool_config_mutex) != 0) {
+        sem_post(&addSchedulerSem);
+        return X_LINK_ERROR;
+    }
+    if (poolThreadCount) {
+        int rc = startPooledLink(&schedulerState[idx]);
+        pthread_mutex_unlock(&pool_config_mutex);
+        if (rc) {
+            XLink_sem_destroy(&schedulerState[idx].remoteSlotSem);
+            XLink_sem_destroy(&schedulerState[idx].notifyDispatcherSem);
+            pthread_mutex_destroy(&schedulerState[idx].queueMutex);
+            schedulerState[idx].schedulerId = -1;
+            schedulerState[idx].dispatcherLinkDown = 1;
+            sem_post(&addSchedulerSem);
+            return X_LINK_ERROR;
+        }
+        numSchedulers++;
+        sem_post(&addSchedulerSem);
+        return X_LINK_SUCCESS;
     }
+    pthread_mutex_unlock(&pool_config_mutex);
+
     if (pthread_attr_init(&attr) != 0) {
         mvLog(MVLOG_ERROR,"pthread_attr_init error");
+        sem_post(&addSchedulerSem);
         return X_LINK_ERROR;
     }
 
@@ -302,8 +509,6 @@ XLinkError_t DispatcherStart(xLinkDeviceHandle_t *deviceHandle)
 #endif
 #endif
 
-    while(((sem_wait(&addSchedulerSem) == -1) && errno == EINTR))
-        continue;
     mvLog(MVLOG_DEBUG,"%s() starting a new thread - schedulerId %d \n", __func__, idx);
     int sc = pthread_create(&schedulerState[idx].xLinkThreadId,
                             &attr,
@@ -314,6 +519,7 @@ XLinkError_t DispatcherStart(xLinkDeviceHandle_t *deviceHandle)
         if (pthread_attr_destroy(&attr) != 0) {
             perror("Thread attr destroy failed\n");
         }
+        sem_post(&addSchedulerSem);
         return X_LINK_ERROR;
     }
 
@@ -356,7 +562,8 @@ int DispatcherDeviceFdDown(xLinkDeviceHandle_t *deviceHandle){
     return dispatcherDeviceFdDown(curr);
 }
 
-xLinkEvent_t* DispatcherAddEvent(xLinkEventOrigin_t origin, xLinkEvent_t *event)
+xLinkEvent_t* DispatcherAddEvent(xLinkEventOrigin_t origin, xLinkEvent_t *event,
+                                 xLinkEventCompletion_t* completion)
 {
     xLinkSchedulerState_t* curr = findCorrespondingScheduler(event->deviceHandle.xLinkFD);
     XLINK_RET_ERR_IF(curr == NULL, NULL);
@@ -365,88 +572,85 @@ xLinkEvent_t* DispatcherAddEvent(xLinkEventOrigin_t origin, xLinkEvent_t *event)
         return NULL;
     }
     mvLog(MVLOG_DEBUG, "Receiving event %s %d\n", TypeToStr(event->header.type), origin);
-    int rc;
-    while(((rc = XLink_sem_wait(&curr->addEventSem)) == -1) && errno == EINTR)
-        continue;
-    if (rc) {
-        mvLog(MVLOG_ERROR,"can't wait semaphore\n");
-        return NULL;
-    }
 
-    XLink_sem_t *sem = NULL;
     xLinkEvent_t* ev;
     if (origin == EVENT_LOCAL) {
+        XLINK_RET_ERR_IF(completion == NULL, NULL);
         event->header.id = createUniqueID();
-        sem = getSem(pthread_self(), curr);
-        if (!sem) {
-            sem = createSem(curr);
-        }
-        if (!sem) {
-            mvLog(MVLOG_WARN,"No more semaphores. Increase XLink or OS resources\n");
-            if (XLink_sem_post(&curr->addEventSem)) {
-                mvLog(MVLOG_ERROR,"can't post semaphore\n");
-            }
-
+        traceEvent(&curr->lQueue, XLINK_TRACE_EVENT_ADDED, origin, event);
+        XLINK_PROBE5(event_enqueue, curr->linkId, event->header.streamId, event->header.id,
+                     event->header.type, event->header.size);
+        if (XLink_sem_init(&completion->sem, 0, 0)) {
+            mvLog(MVLOG_ERROR, "Can't create semaphore\n");
             return NULL;
         }
         const uint32_t tmpMoveSem = event->header.flags.bitField.moveSemantic;
+        const uint32_t tmpHandshake = event->header.flags.bitField.handshake;
         event->header.flags.raw = 0;
         event->header.flags.bitField.moveSemantic = tmpMoveSem;
-        ev = addNextQueueElemToProc(curr, &curr->lQueue, event, sem, origin);
+        event->header.flags.bitField.handshake = tmpHandshake;
+        if (submitLocalEvent(&curr->submitQueue, event, &completion->sem, NULL)) {
+            mvLog(MVLOG_ERROR, "Local event queue is full");
+            XLink_sem_destroy(&completion->sem);
+            return NULL;
+        }
+        ev = event;
     } else {
+        traceEvent(&curr->rQueue, XLINK_TRACE_EVENT_ADDED, origin, event);
+        XLINK_PROBE5(event_enqueue, curr->linkId, event->header.streamId, event->header.id,
+                     event->header.type, event->header.size);
         ev = addNextQueueElemToProc(curr, &curr->rQueue, event, NULL, origin);
     }
-    if (XLink_sem_post(&curr->addEventSem)) {
-        mvLog(MVLOG_ERROR,"can't post semaphore\n");
-    }
-    if (XLink_sem_post(&curr->notifyDispatcherSem)) {
-        mvLog(MVLOG_ERROR, "can't post semaphore\n");
-    }
+    wakeDispatcher(curr);
     return ev;
 }
 
-int DispatcherWaitEventComplete(xLinkDeviceHandle_t *deviceHandle, unsigned int timeoutMs)
+xLinkEvent_t* DispatcherAddEventAsync(xLinkEvent_t *event, xLinkEventCallback_t callback)
 {
-    xLinkSchedulerState_t* curr = findCorrespondingScheduler(deviceHandle->xLinkFD);
-    ASSERT_XLINK(curr != NULL);
+    XLINK_RET_ERR_IF(callback == NULL, NULL);
+    xLinkSchedulerState_t* curr = findCorrespondingScheduler(event->deviceHandle.xLinkFD);
+    XLINK_RET_ERR_IF(curr == NULL, NULL);
 
-    XLink_sem_t* id = getSem(pthread_self(), curr);
-    if (id == NULL) {
-        return -1;
+    if(curr->resetXLink) {
+        return NULL;
+    }
+    mvLog(MVLOG_DEBUG, "Receiving async event %s\n", TypeToStr(event->header.type));
+
+    event->header.id = createUniqueID();
+    event->header.flags.raw = 0;
+    if (submitLocalEvent(&curr->submitQueue, event, NULL, callback)) {
+        mvLog(MVLOG_ERROR, "Local event queue is full");
+        return NULL;
     }
+    wakeDispatcher(curr);
+    return event;
+}
 
+int DispatcherWaitEventComplete(xLinkDeviceHandle_t *deviceHandle,
+                                xLinkEventCompletion_t* completion, unsigned int timeoutMs)
+{
+    ASSERT_XLINK(completion != NULL);
+
+    XLink_sem_t* id = &completion->sem;
     int rc = 0;
     if (timeoutMs != XLINK_NO_RW_TIMEOUT) {
-        // This is a workaround for sem_timedwait being influenced by the system clock change.
-        // This is a temporary solution. TODO: replace this with something more efficient.
-        while (timeoutMs--) {
-            rc = XLink_sem_trywait(id);
-            if (!rc) {
-                break;
-            } else {
-#if (defined(_WIN32) || defined(_WIN64) )
-                Sleep(1);
-#else
-                usleep(1000);
-#endif
-            }
-        }
+        rc = XLink_sem_timedwait_ms(id, timeoutMs);
     } else {
         while(((rc = XLink_sem_wait(id)) == -1) && errno == EINTR)
             continue;
     }
+    // The scheduler may be already gone, after serving all its events
+    xLinkSchedulerState_t* curr = findCorrespondingScheduler(deviceHandle->xLinkFD);
+    rc = finishCompletion(curr, completion, rc);
 #ifndef __DEVICE__
-    if (rc) {
+    if (rc && curr != NULL) {
             xLinkEvent_t event = {0};
             event.header.type = XLINK_RESET_REQ;
             event.deviceHandle = *deviceHandle;
             mvLog(MVLOG_ERROR,"waiting is timeout, sending reset remote event");
-            DispatcherAddEvent(EVENT_LOCAL, &event);
-            id = getSem(pthread_self(), curr);
-            int rc;
-            while(((rc = XLink_sem_wait(id)) == -1) && errno == EINTR)
-                continue;
-            if (id == NULL || rc) {
+            xLinkEventCompletion_t resetCompletion;
+            if (DispatcherAddEvent(EVENT_LOCAL, &event, &resetCompletion) == NULL ||
+                DispatcherWaitEventComplete(deviceHandle, &resetCompletion, XLINK_NO_RW_TIMEOUT)) {
             // Calling non-thread safe dispatcherReset from external thread
             // TODO - investigate further and resolve
                 dispatcherReset(curr);
@@ -457,21 +661,19 @@ int DispatcherWaitEventComplete(xLinkDeviceHandle_t *deviceHandle, unsigned int
     return rc;
 }
 
-int DispatcherWaitEventCompleteTimeout(xLinkDeviceHandle_t *deviceHandle, struct timespec abstime)
+int DispatcherWaitEventCompleteTimeout(xLinkDeviceHandle_t *deviceHandle,
+                                       xLinkEventCompletion_t* completion, unsigned int timeoutMs)
 {
-    xLinkSchedulerState_t* curr = findCorrespondingScheduler(deviceHandle->xLinkFD);
-    ASSERT_XLINK(curr != NULL);
-
-    XLink_sem_t* id = getSem(pthread_self(), curr);
-    if (id == NULL) {
-        return -1;
-    }
+    ASSERT_XLINK(completion != NULL);
 
-    int rc = XLink_sem_timedwait(id, &abstime);
+    // monotonic, a wall clock change neither shortens nor extends the wait
+    int rc = XLink_sem_timedwait_ms(&completion->sem, timeoutMs);
     int err = errno;
+    xLinkSchedulerState_t* curr = findCorrespondingScheduler(deviceHandle->xLinkFD);
+    rc = finishCompletion(curr, completion, rc);
 
 #ifndef __DEVICE__
-    if (rc) {
+    if (rc && curr != NULL) {
         if(err == ETIMEDOUT){
             return X_LINK_TIMEOUT;
         } else {
@@ -479,9 +681,9 @@ int DispatcherWaitEventCompleteTimeout(xLinkDeviceHandle_t *deviceHandle, struct
             event.header.type = XLINK_RESET_REQ;
             event.deviceHandle = *deviceHandle;
             mvLog(MVLOG_ERROR,"waiting is timeout, sending reset remote event");
-            DispatcherAddEvent(EVENT_LOCAL, &event);
-            id = getSem(pthread_self(), curr);
-            if (id == NULL || XLink_sem_wait(id)) {
+            xLinkEventCompletion_t resetCompletion;
+            if (DispatcherAddEvent(EVENT_LOCAL, &event, &resetCompletion) == NULL ||
+                DispatcherWaitEventComplete(deviceHandle, &resetCompletion, XLINK_NO_RW_TIMEOUT)) {
                 // Calling non-thread safe dispatcherReset from external thread
                 // TODO - investigate further and resolve
                 dispatcherReset(curr);
@@ -493,6 +695,44 @@ int DispatcherWaitEventCompleteTimeout(xLinkDeviceHandle_t *deviceHandle, struct
     return rc;
 }
 
+int DispatcherWaitEventCompleteOrWithdraw(xLinkDeviceHandle_t *deviceHandle,
+                                          xLinkEventCompletion_t* completion,
+                                          unsigned int timeoutMs, const xLinkEvent_t* event)
+{
+    ASSERT_XLINK(completion != NULL);
+    ASSERT_XLINK(event != NULL);
+
+    int rc = XLink_sem_timedwait_ms(&completion->sem, timeoutMs);
+    xLinkSchedulerState_t* curr = findCorrespondingScheduler(deviceHandle->xLinkFD);
+    if (rc == 0 || curr == NULL) {
+        return finishCompletion(curr, completion, rc) ? X_LINK_TIMEOUT : X_LINK_SUCCESS;
+    }
+
+    if (pthread_mutex_lock(&(curr->queueMutex)) != 0) {
+        mvLog(MVLOG_ERROR, "can't lock queueMutex\n");
+        return finishCompletion(curr, completion, rc) ? X_LINK_TIMEOUT : X_LINK_SUCCESS;
+    }
+    int withdrawn = withdrawEventLocked(curr, completion);
+    if (withdrawn) {
+        detachCompletionLocked(curr, completion);
+    }
+    XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+
+    if (withdrawn) {
+        // The event could have been completed before it was withdrawn
+        rc = XLink_sem_trywait(&completion->sem);
+        XLink_sem_destroy(&completion->sem);
+        return rc ? X_LINK_TIMEOUT : X_LINK_SUCCESS;
+    }
+
+    // Being processed, the scheduler serves it without blocking it again
+    rc = XLink_sem_wait(&completion->sem);
+    XLink_sem_destroy(&completion->sem);
+    if (rc || event->header.flags.bitField.block) {
+        return X_LINK_TIMEOUT;
+    }
+    return X_LINK_SUCCESS;
+}
 
 char* TypeToStr(int type)
 {
@@ -531,28 +771,19 @@ int DispatcherUnblockEvent(eventId_t id, xLinkEventType_t type, streamId_t strea
     xLinkEventPriv_t* blockedEvent;
 
     XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, 1);
-    for (blockedEvent = curr->lQueue.q;
-         blockedEvent < curr->lQueue.q + MAX_EVENTS;
-         blockedEvent++)
+    for (blockedEvent = getBlockedList(&curr->lQueue, stream, type)->head;
+         blockedEvent != NULL;
+         blockedEvent = blockedEvent->next)
     {
-        if (blockedEvent->isServed == EVENT_BLOCKED &&
-            ((blockedEvent->packet.header.id == id || id == -1)
-             && blockedEvent->packet.header.type == type
-             && blockedEvent->packet.header.streamId == stream))
+        if (isEventMatching(blockedEvent, id, type, stream))
         {
             mvLog(MVLOG_DEBUG,"unblocked**************** %d %s\n",
                   (int)blockedEvent->packet.header.id,
                   TypeToStr((int)blockedEvent->packet.header.type));
-            blockedEvent->isServed = EVENT_READY;
-            if (XLink_sem_post(&curr->notifyDispatcherSem)){
-                mvLog(MVLOG_ERROR, "can't post semaphore\n");
-            }
+            setEventState(blockedEvent, EVENT_READY);
             XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
+            wakeDispatcher(curr);
             return 1;
-        } else {
-            mvLog(MVLOG_DEBUG,"%d %s\n",
-                  (int)blockedEvent->packet.header.id,
-                  TypeToStr((int)blockedEvent->packet.header.type));
         }
     }
     XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
@@ -564,22 +795,33 @@ int DispatcherServeEvent(eventId_t id, xLinkEventType_t type, streamId_t stream,
     xLinkSchedulerState_t* curr = findCorrespondingScheduler(xlinkFD);
     ASSERT_XLINK(curr != NULL);
 
-    xLinkEventPriv_t* event;
+    eventQueueHandler_t* q = &curr->lQueue;
+    // Lists which can hold a matching event, the indexed ones first
+    eventList_t* lists[EVENT_INDEX_SIZE + 3];
+    int listsCount = 0;
+    if (id != -1) {
+        lists[listsCount++] = getPendingList(q, id);
+    } else {
+        for (int i = 0; i < EVENT_INDEX_SIZE; i++) {
+            lists[listsCount++] = &q->pending[i];
+        }
+    }
+    lists[listsCount++] = getBlockedList(q, stream, type);
+    lists[listsCount++] = &q->ready;
+    lists[listsCount++] = &q->allocated;
+
     XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, 1);
-    for (event = curr->lQueue.q;
-         event < curr->lQueue.q + MAX_EVENTS;
-         event++)
-    {
-        if (((event->packet.header.id == id || id == -1)
-             && event->packet.header.type == type
-             && event->packet.header.streamId == stream))
-        {
-            mvLog(MVLOG_DEBUG,"served**************** %d %s\n",
-                  (int)event->packet.header.id,
-                  TypeToStr((int)event->packet.header.type));
-            event->isServed = EVENT_SERVED;
-            XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
-            return 1;
+    for (int i = 0; i < listsCount; i++) {
+        for (xLinkEventPriv_t* event = lists[i]->head; event != NULL; event = event->next) {
+            if (isEventMatching(event, id, type, stream))
+            {
+                mvLog(MVLOG_DEBUG,"served**************** %d %s\n",
+                      (int)event->packet.header.id,
+                      TypeToStr((int)event->packet.header.type));
+                setEventState(event, EVENT_SERVED);
+                XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
+                return 1;
+            }
         }
     }
     XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
@@ -596,87 +838,6 @@ int DispatcherServeEvent(eventId_t id, xLinkEventType_t type, streamId_t stream,
 // Helpers implementation. Begin.
 // ------------------------------------
 
-int pthread_t_compare(pthread_t a, pthread_t b)
-{
-#if (defined(_WIN32) || defined(_WIN64) )
-#ifdef __GNUC__
-    return  (a == b);
-#else
-    return ((a.tid == b.tid));
-#endif
-#else
-    return  (a == b);
-#endif
-}
-
-static XLink_sem_t* createSem(xLinkSchedulerState_t* curr)
-{
-    XLINK_RET_ERR_IF(curr == NULL, NULL);
-
-    XLink_sem_t* sem = getSem(pthread_self(), curr);
-    if (sem) {// it already exists, error
-        return NULL;
-    }
-
-    if (curr->semaphores <= MAXIMUM_SEMAPHORES) {
-        localSem_t* temp = curr->eventSemaphores;
-
-        while (temp < curr->eventSemaphores + MAXIMUM_SEMAPHORES) {
-            int refs = 0;
-            XLINK_RET_ERR_IF(XLink_sem_get_refs(&temp->sem, &refs), NULL);
-            if (refs < 0 || curr->semaphores == MAXIMUM_SEMAPHORES) {
-                if (curr->semaphores == MAXIMUM_SEMAPHORES && refs == 0) {
-                    XLINK_RET_ERR_IF(XLink_sem_destroy(&temp->sem), NULL);
-                    XLINK_RET_ERR_IF(XLink_sem_get_refs(&temp->sem, &refs), NULL);
-                    curr->semaphores --;
-#if (defined(_WIN32) || defined(_WIN64))
-                    memset(&temp->threadId, 0, sizeof(temp->threadId));
-#else
-                    temp->threadId = 0;
-#endif
-                }
-
-                if (refs == -1) {
-                    sem = &temp->sem;
-                    if (XLink_sem_init(sem, 0, 0)){
-                        mvLog(MVLOG_ERROR, "Error: Can't create semaphore\n");
-                        return NULL;
-                    }
-                    curr->semaphores++;
-                    temp->threadId = pthread_self();
-                    break;
-                }
-            }
-            temp++;
-        }
-        if (!sem) {
-            return NULL; //shouldn't happen
-        }
-    }
-    else {
-        mvLog(MVLOG_ERROR, "Error: cached semaphores %d exceeds the MAXIMUM_SEMAPHORES %d", curr->semaphores, MAXIMUM_SEMAPHORES);
-        return NULL;
-    }
-
-    return sem;
-}
-
-static XLink_sem_t* getSem(pthread_t threadId, xLinkSchedulerState_t *curr)
-{
-    XLINK_RET_ERR_IF(curr == NULL, NULL);
-
-    localSem_t* temp = curr->eventSemaphores;
-    while (temp < curr->eventSemaphores + MAXIMUM_SEMAPHORES) {
-        int refs = 0;
-        XLINK_RET_ERR_IF(XLink_sem_get_refs(&temp->sem, &refs), NULL);
-        if (pthread_t_compare(temp->threadId, threadId) && refs >= 0) {
-            return &temp->sem;
-        }
-        temp++;
-    }
-    return NULL;
-}
-
 #if (defined(_WIN32) || defined(_WIN64))
 static void* __cdecl eventReader(void* ctx)
 #else
@@ -693,6 +854,8 @@ static void* eventReader(void* ctx)
     mvLog(MVLOG_INFO,"eventReader thread started");
 
     while (!curr->resetXLink) {
+        // don't take the next event off the link before it can be queued
+        waitForRemoteSlot(curr);
         int sc = glControlFunc->eventReceive(&event);
 
         mvLog(MVLOG_DEBUG,"Reading %s (scheduler %d, fd %p, event id %d, event stream_id %u, event size %u)\n",
@@ -704,10 +867,11 @@ static void* eventReader(void* ctx)
             dispatcherFreeEvents(&curr->lQueue, EVENT_PENDING);
             dispatcherFreeEvents(&curr->lQueue, EVENT_BLOCKED);
             XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, NULL);
+            runEventCallbacks(curr);
             continue;
         }
 
-        DispatcherAddEvent(EVENT_REMOTE, &event);
+        DispatcherAddEvent(EVENT_REMOTE, &event, NULL);
 
         if (event.header.type == XLINK_RESET_REQ) {
             curr->resetXLink = 1;
@@ -718,6 +882,94 @@ static void* eventReader(void* ctx)
     return 0;
 }
 
+/**
+ * @brief Counterpart of eventReader for links served by the shared reader threads.
+ *        Takes the events already received off the link, without blocking.
+ */
+static int reactorReadEvents(xLinkReactorSource_t* source)
+{
+    xLinkSchedulerState_t* curr = (xLinkSchedulerState_t*)source->context;
+    xLinkEvent_t* event = &curr->reactorEvent;
+
+    // bounded, a busy link must not starve the others served by the thread
+    for (int i = 0; i < XLINK_REACTOR_EVENTS_PER_WAKEUP; i++) {
+        if (curr->resetXLink) {
+            return XLINK_REACTOR_STOP;
+        }
+        if (curr->reactorReceiveState.headerBytes == 0) {
+            // don't take the next event off the link before it can be queued,
+            // reading resumes once the scheduler frees a slot
+            XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, XLINK_REACTOR_STOP);
+            int full = curr->rQueue.free.head == NULL;
+            if (full) {
+                curr->readerWaiting = 1;
+            }
+            XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, XLINK_REACTOR_STOP);
+            if (full) {
+                return XLINK_REACTOR_PAUSE;
+            }
+        }
+
+        int sc = glControlFunc->eventReceivePartial(event, &curr->reactorReceiveState);
+        if (sc == XLINK_RECEIVE_INCOMPLETE) {
+            return XLINK_REACTOR_CONTINUE;
+        }
+        if (sc != XLINK_RECEIVE_COMPLETE) {
+            mvLog(MVLOG_DEBUG,"Failed to receive event (err %d)", sc);
+            XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, XLINK_REACTOR_STOP);
+            dispatcherFreeEvents(&curr->lQueue, EVENT_PENDING);
+            dispatcherFreeEvents(&curr->lQueue, EVENT_BLOCKED);
+            XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, XLINK_REACTOR_STOP);
+            runEventCallbacks(curr);
+            if (sc == XLINK_RECEIVE_DROPPED) {
+                continue;
+            }
+            // Nothing more comes from the link, take it down like a remote reset.
+            // An eventReader thread would keep failing on the read instead.
+            XLink_atomic_store(&curr->resetXLink, 1);
+            wakeDispatcher(curr);
+            return XLINK_REACTOR_STOP;
+        }
+
+        mvLog(MVLOG_DEBUG,"Reading %s (scheduler %d, fd %p, event id %d, event stream_id %u, event size %u)\n",
+              TypeToStr(event->header.type), curr->schedulerId, event->deviceHandle.xLinkFD, event->header.id, event->header.streamId, event->header.size);
+
+        DispatcherAddEvent(EVENT_REMOTE, event, NULL);
+
+        if (event->header.type == XLINK_RESET_REQ) {
+            curr->resetXLink = 1;
+            mvLog(MVLOG_DEBUG,"Read XLINK_RESET_REQ, stopping reading the link.");
+            return XLINK_REACTOR_STOP;
+        }
+    }
+    // events read ahead don't make the descriptor readable again
+    return curr->reactorReceiveState.pendingBytes ? XLINK_REACTOR_AGAIN : XLINK_REACTOR_CONTINUE;
+}
+
+/**
+ * @brief Hands reading the link to the shared reader threads, if enabled and
+ *        supported by the link's transport
+ * @return 0 if the link is read by the shared threads
+ */
+static int startReactorReading(xLinkSchedulerState_t* curr)
+{
+    if (XLinkReactorGetThreads() == 0 ||
+        glControlFunc->eventReceivePartial == NULL ||
+        glControlFunc->eventReceiveCancel == NULL) {
+        return -1;
+    }
+
+    memset(&curr->reactorEvent, 0, sizeof(curr->reactorEvent));
+    curr->reactorEvent.header.id = -1;
+    curr->reactorEvent.deviceHandle = curr->deviceHandle;
+    memset(&curr->reactorReceiveState, 0, sizeof(curr->reactorReceiveState));
+
+    curr->reactorSource.fd = XLinkPlatformGetPollFd(&curr->deviceHandle);
+    curr->reactorSource.context = curr;
+    curr->reactorSource.onReadable = reactorReadEvents;
+    return XLinkReactorAdd(&curr->reactorSource);
+}
+
 #if (defined(_WIN32) || defined(_WIN64))
 static void* __cdecl eventSchedulerRun(void* ctx)
 #else
@@ -762,22 +1014,25 @@ static void* eventSchedulerRun(void* ctx)
     }
 #endif
 #endif
-    sc = pthread_create(&readerThreadId, &attr, eventReader, curr);
-    if (sc) {
-        mvLog(MVLOG_ERROR, "Thread creation failed");
-        if (pthread_attr_destroy(&attr) != 0) {
-            perror("Thread attr destroy failed\n");
+    curr->reactorActive = startReactorReading(curr) == 0;
+    if (!curr->reactorActive) {
+        sc = pthread_create(&readerThreadId, &attr, eventReader, curr);
+        if (sc) {
+            mvLog(MVLOG_ERROR, "Thread creation failed");
+            if (pthread_attr_destroy(&attr) != 0) {
+                perror("Thread attr destroy failed\n");
+            }
+            return NULL;
         }
-        return NULL;
-    }
 #ifndef __APPLE__
-    char eventReaderThreadName[MVLOG_MAXIMUM_THREAD_NAME_SIZE + 8];
-    snprintf(eventReaderThreadName, sizeof(eventReaderThreadName), "EventRead%.2dThr", schedulerId);
-    sc = pthread_setname_np(readerThreadId, eventReaderThreadName);
-    if (sc != 0) {
-        perror("Setting name for event reader thread failed");
-    }
+        char eventReaderThreadName[MVLOG_MAXIMUM_THREAD_NAME_SIZE + 8];
+        snprintf(eventReaderThreadName, sizeof(eventReaderThreadName), "EventRead%.2dThr", schedulerId);
+        sc = pthread_setname_np(readerThreadId, eventReaderThreadName);
+        if (sc != 0) {
+            perror("Setting name for event reader thread failed");
+        }
 #endif
+    }
     mvLog(MVLOG_INFO,"Scheduler thread started");
 
     XLinkError_t rc = sendEvents(curr);
@@ -785,10 +1040,16 @@ static void* eventSchedulerRun(void* ctx)
         mvLog(MVLOG_ERROR, "sendEvents method finished with an error: %s", XLinkErrorToStr(rc));
     }
 
-    sc = pthread_join(readerThreadId, NULL);
-    if (sc) {
-        mvLog(MVLOG_ERROR, "Waiting for thread failed");
+    if (curr->reactorActive) {
+        XLinkReactorRemove(&curr->reactorSource);
+        glControlFunc->eventReceiveCancel(&curr->reactorEvent, &curr->reactorReceiveState);
+    } else {
+        sc = pthread_join(readerThreadId, NULL);
+        if (sc) {
+            mvLog(MVLOG_ERROR, "Waiting for thread failed");
+        }
     }
+    XLink_sem_destroy(&curr->remoteSlotSem);
 
     sc = pthread_attr_destroy(&attr);
     if (sc) {
@@ -808,48 +1069,452 @@ static void* eventSchedulerRun(void* ctx)
     return NULL;
 }
 
-static int isEventTypeRequest(xLinkEventPriv_t* event)
+#if (defined(_WIN32) || defined(_WIN64))
+static void* __cdecl schedulerWorkerRun(void* ctx)
+#else
+static void* schedulerWorkerRun(void* ctx)
+#endif
 {
-    return event->packet.header.type < XLINK_REQUEST_LAST;
-}
+    (void)ctx;
+    unsigned int waitMs = XLINK_NO_RW_TIMEOUT;
 
-static void postAndMarkEventServed(xLinkEventPriv_t *event)
-{
-    if (event->retEv){
-        // the xLinkEventPriv_t slot pointed by "event" will be
-        // re-cycled as soon as we mark it as EVENT_SERVED,
-        // so before that, we copy the result event into XLink API layer
-        *(event->retEv) = event->packet;
-    }
-    if(event->sem){
-        if (XLink_sem_post(event->sem)) {
-            mvLog(MVLOG_ERROR,"can't post semaphore\n");
+    mvLog(MVLOG_INFO,"Scheduler worker started");
+
+    for (;;) {
+        if (waitMs == XLINK_NO_RW_TIMEOUT) {
+            while (XLink_sem_wait(&poolRunSem) == -1 && errno == EINTR)
+                continue;
+        } else {
+            // woken up in time for deferred work of an idle link
+            while (XLink_sem_timedwait_ms(&poolRunSem, waitMs) == -1 && errno == EINTR)
+                continue;
         }
-    }
 
-    event->isServed = EVENT_SERVED;
-}
+        XLINK_RET_ERR_IF(pthread_mutex_lock(&pool_mutex) != 0, NULL);
+        if (poolStopping) {
+            pthread_mutex_unlock(&pool_mutex);
+            break;
+        }
+        waitMs = scheduleDueLinks();
+        xLinkSchedulerState_t* curr = NULL;
+        if (poolRunCount) {
+            curr = poolRunQueue[poolRunHead];
+            poolRunHead = (poolRunHead + 1) % MAX_SCHEDULERS;
+            poolRunCount--;
+        }
+        pthread_mutex_unlock(&pool_mutex);
 
-static int createUniqueID()
-{
-    static eventId_t id = 0xa;
-    eventId_t idCopy = 0;
-    XLINK_RET_ERR_IF(pthread_mutex_lock(&unique_id_mutex) != 0, -1);
-    id++;
-    if(id >= INT32_MAX){
-        id = 0xa;
+        if (curr) {
+            // hand timing the deferred work over to an idle worker
+            if (waitMs != XLINK_NO_RW_TIMEOUT && XLink_sem_post(&poolRunSem)) {
+                mvLog(MVLOG_ERROR, "can't post semaphore\n");
+            }
+            runPooledLink(curr);
+            waitMs = XLINK_NO_RW_TIMEOUT;
+        }
     }
-    idCopy = id;
-    XLINK_RET_ERR_IF(pthread_mutex_unlock(&unique_id_mutex) != 0, -1);
 
-    return idCopy;
+    mvLog(MVLOG_INFO,"Scheduler worker stopped");
+    return NULL;
 }
 
-int findAvailableScheduler()
-{
+#if (defined(_WIN32) || defined(_WIN64))
+static void* __cdecl pooledReaderRun(void* ctx)
+#else
+static void* pooledReaderRun(void* ctx)
+#endif
+{
+    pooledReader_t* reader = (pooledReader_t*)ctx;
+
+    for (;;) {
+        while (XLink_sem_wait(&reader->startSem) == -1 && errno == EINTR)
+            continue;
+        xLinkSchedulerState_t* curr = reader->link;
+        if (curr == NULL) {
+            break;
+        }
+
+        eventReader(curr);
+        finishPooledLinkPart(curr);
+
+        XLINK_RET_ERR_IF(pthread_mutex_lock(&pool_mutex) != 0, NULL);
+        reader->link = NULL;
+        reader->busy = 0;
+        pthread_mutex_unlock(&pool_mutex);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Hands a started link to the shared workers, called with pool_config_mutex held
+ */
+static int startPooledLink(xLinkSchedulerState_t* curr)
+{
+    XLINK_RET_ERR_IF(pthread_mutex_lock(&pool_mutex) != 0, -1);
+    if (poolThreadsRunning == 0 && startPoolThreads()) {
+        pthread_mutex_unlock(&pool_mutex);
+        return -1;
+    }
+    poolLinkCount++;
+    curr->runState = LINK_IDLE;
+    curr->pendingStops = 2;
+    curr->deferredDueMs = UINT64_MAX;
+    curr->pooled = 1;
+    pthread_mutex_unlock(&pool_mutex);
+
+    curr->reactorActive = startReactorReading(curr) == 0;
+    if (!curr->reactorActive && startPooledReader(curr)) {
+        mvLog(MVLOG_ERROR, "Can't start a reader for the link");
+        XLINK_RET_ERR_IF(pthread_mutex_lock(&pool_mutex) != 0, -1);
+        curr->pooled = 0;
+        poolLinkCount--;
+        pthread_mutex_unlock(&pool_mutex);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Runs eventReader for the link on an idle reader thread, or a new one
+ */
+static int startPooledReader(xLinkSchedulerState_t* curr)
+{
+    XLINK_RET_ERR_IF(pthread_mutex_lock(&pool_mutex) != 0, -1);
+    pooledReader_t* reader = NULL;
+    for (unsigned int i = 0; i < poolReadersStarted; i++) {
+        if (!poolReaders[i].busy) {
+            reader = &poolReaders[i];
+            break;
+        }
+    }
+    if (reader == NULL) {
+        if (poolReadersStarted == MAX_SCHEDULERS) {
+            pthread_mutex_unlock(&pool_mutex);
+            return -1;
+        }
+        reader = &poolReaders[poolReadersStarted];
+        if (XLink_sem_init(&reader->startSem, 0, 0)) {
+            pthread_mutex_unlock(&pool_mutex);
+            return -1;
+        }
+        if (pthread_create(&reader->threadId, NULL, pooledReaderRun, reader)) {
+            mvLog(MVLOG_ERROR, "Thread creation failed");
+            XLink_sem_destroy(&reader->startSem);
+            pthread_mutex_unlock(&pool_mutex);
+            return -1;
+        }
+#ifndef __APPLE__
+        char eventReaderThreadName[MVLOG_MAXIMUM_THREAD_NAME_SIZE + 8];
+        snprintf(eventReaderThreadName, sizeof(eventReaderThreadName), "EventRead%.2dThr", (int)poolReadersStarted);
+        if (pthread_setname_np(reader->threadId, eventReaderThreadName) != 0) {
+            perror("Setting name for event reader thread failed");
+        }
+#endif
+        poolReadersStarted++;
+    }
+    reader->busy = 1;
+    reader->link = curr;
+    pthread_mutex_unlock(&pool_mutex);
+
+    if (XLink_sem_post(&reader->startSem)) {
+        mvLog(MVLOG_ERROR, "can't post semaphore\n");
+    }
+    return 0;
+}
+
+/**
+ * @brief Serves a turn of the link's events on a worker. A link is run by
+ *        one worker at a time, the others take the other runnable links.
+ */
+static void runPooledLink(xLinkSchedulerState_t* curr)
+{
+    XLink_atomic_store(&curr->runState, LINK_RUNNING);
+
+    for (;;) {
+        int served = 0;
+        while (!curr->resetXLink && served < XLINK_POOL_EVENTS_PER_TURN) {
+            if (glControlFunc->flushDeferred && getMonotonicTimestampMs() >= curr->deferredCheckMs) {
+                flushDeferredWork(curr);
+            }
+            xLinkEventPriv_t* event = takeNextEvent(curr);
+            if (event == NULL) {
+                break;
+            }
+            XLinkError_t rc = serveEvent(curr, event);
+            if (rc) {
+                mvLog(MVLOG_ERROR, "Serving the event failed with an error: %s", XLinkErrorToStr(rc));
+                curr->resetXLink = 1;
+            }
+            served++;
+        }
+        flushHeldSends(curr);
+
+        if (curr->resetXLink) {
+            XLink_atomic_store(&curr->runState, LINK_CLOSED);
+            if (curr->reactorActive) {
+                XLinkReactorRemove(&curr->reactorSource);
+                glControlFunc->eventReceiveCancel(&curr->reactorEvent, &curr->reactorReceiveState);
+                finishPooledLinkPart(curr);
+            }
+            finishPooledLinkPart(curr);
+            return;
+        }
+
+        if (served == XLINK_POOL_EVENTS_PER_TURN) {
+            // more work is likely, give the other runnable links a turn first
+            XLink_atomic_store(&curr->runState, LINK_QUEUED);
+            pushRunnableLink(curr);
+            return;
+        }
+
+        unsigned int deferredMs = flushDeferredWork(curr);
+        flushHeldSends(curr);
+        if (curr->resetXLink) {
+            continue;
+        }
+        if (deferredMs != XLINK_NO_RW_TIMEOUT) {
+            if (pthread_mutex_lock(&pool_mutex) == 0) {
+                curr->deferredDueMs = getMonotonicTimestampMs() + deferredMs;
+                pthread_mutex_unlock(&pool_mutex);
+            }
+            // let a waiting worker take the new deadline into account
+            if (XLink_sem_post(&poolRunSem)) {
+                mvLog(MVLOG_ERROR, "can't post semaphore\n");
+            }
+        }
+
+        uint32_t state = LINK_RUNNING;
+        if (XLink_atomic_compare_exchange(&curr->runState, &state, LINK_IDLE)) {
+            return;
+        }
+        // notified while serving, look for the new work
+        XLink_atomic_store(&curr->runState, LINK_RUNNING);
+    }
+}
+
+/**
+ * @brief Makes the link runnable, the pooled counterpart of waking its scheduler thread
+ */
+static void scheduleLink(xLinkSchedulerState_t* curr)
+{
+    uint32_t state = XLink_atomic_load(&curr->runState);
+    for (;;) {
+        if (state == LINK_IDLE) {
+            if (XLink_atomic_compare_exchange(&curr->runState, &state, LINK_QUEUED)) {
+                pushRunnableLink(curr);
+                return;
+            }
+        } else if (state == LINK_RUNNING) {
+            if (XLink_atomic_compare_exchange(&curr->runState, &state, LINK_RUNNING_NOTIFIED)) {
+                return;
+            }
+        } else {
+            return;
+        }
+    }
+}
+
+static void pushRunnableLink(xLinkSchedulerState_t* curr)
+{
+    if (pthread_mutex_lock(&pool_mutex) != 0) {
+        return;
+    }
+    // each link is queued once at most
+    poolRunQueue[(poolRunHead + poolRunCount) % MAX_SCHEDULERS] = curr;
+    poolRunCount++;
+    pthread_mutex_unlock(&pool_mutex);
+
+    if (XLink_sem_post(&poolRunSem)) {
+        mvLog(MVLOG_ERROR, "can't post semaphore\n");
+    }
+}
+
+/**
+ * @brief Queues the idle links whose deferred work is due, called with pool_mutex held
+ * @return Milliseconds until the next deferred work, XLINK_NO_RW_TIMEOUT if there is none
+ */
+static unsigned int scheduleDueLinks(void)
+{
+    uint64_t now = getMonotonicTimestampMs();
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < MAX_SCHEDULERS; i++) {
+        xLinkSchedulerState_t* curr = &schedulerState[i];
+        if (!curr->pooled || curr->deferredDueMs == UINT64_MAX) {
+            continue;
+        }
+        if (curr->deferredDueMs > now) {
+            next = MIN(next, curr->deferredDueMs);
+            continue;
+        }
+
+        curr->deferredDueMs = UINT64_MAX;
+        uint32_t state = LINK_IDLE;
+        if (XLink_atomic_compare_exchange(&curr->runState, &state, LINK_QUEUED)) {
+            poolRunQueue[(poolRunHead + poolRunCount) % MAX_SCHEDULERS] = curr;
+            poolRunCount++;
+            if (XLink_sem_post(&poolRunSem)) {
+                mvLog(MVLOG_ERROR, "can't post semaphore\n");
+            }
+        } else if (state == LINK_RUNNING) {
+            XLink_atomic_compare_exchange(&curr->runState, &state, LINK_RUNNING_NOTIFIED);
+        }
+    }
+    return next == UINT64_MAX ? XLINK_NO_RW_TIMEOUT : (unsigned int)(next - now);
+}
+
+/**
+ * @brief Called by the worker and by the reader once they are done with a
+ *        closing link, the last one resets it like eventSchedulerRun does
+ */
+static void finishPooledLinkPart(xLinkSchedulerState_t* curr)
+{
+    if (XLink_atomic_fetch_add(&curr->pendingStops, (uint32_t)-1) != 1) {
+        return;
+    }
+
+    XLink_sem_destroy(&curr->remoteSlotSem);
+    // the slot may be taken by a new link once reset
+    if (pthread_mutex_lock(&pool_mutex) == 0) {
+        curr->pooled = 0;
+        poolLinkCount--;
+        pthread_mutex_unlock(&pool_mutex);
+    }
+
+    if (dispatcherReset(curr) != 0) {
+        mvLog(MVLOG_WARN, "Failed to reset or was already reset");
+    }
+    mvLog(MVLOG_INFO,"Link scheduling stopped");
+}
+
+// Called with pool_mutex held
+static int startPoolThreads(void)
+{
+    if (XLink_sem_init(&poolRunSem, 0, 0)) {
+        mvLog(MVLOG_ERROR, "Can't create semaphore\n");
+        return -1;
+    }
+
+    unsigned int started = 0;
+    for (; started < poolThreadCount; started++) {
+        if (pthread_create(&poolThreads[started], NULL, schedulerWorkerRun, NULL)) {
+            mvLog(MVLOG_ERROR, "Thread creation failed");
+            break;
+        }
+#ifndef __APPLE__
+        char workerThreadName[MVLOG_MAXIMUM_THREAD_NAME_SIZE];
+        snprintf(workerThreadName, sizeof(workerThreadName), "SchedWork%.2dThr", (int)started);
+        if (pthread_setname_np(poolThreads[started], workerThreadName) != 0) {
+            perror("Setting name for scheduler worker thread failed");
+        }
+#endif
+    }
+
+    poolThreadsRunning = started;
+    if (started == 0) {
+        XLink_sem_destroy(&poolRunSem);
+        return -1;
+    }
+    return 0;
+}
+
+// Called with pool_config_mutex held, once no link uses the workers
+static void stopPoolThreads(void)
+{
+    if (pthread_mutex_lock(&pool_mutex) != 0) {
+        return;
+    }
+    unsigned int workers = poolThreadsRunning;
+    unsigned int readers = poolReadersStarted;
+    poolStopping = 1;
+    pthread_mutex_unlock(&pool_mutex);
+
+    for (unsigned int i = 0; i < workers; i++) {
+        if (XLink_sem_post(&poolRunSem)) {
+            mvLog(MVLOG_ERROR, "can't post semaphore\n");
+        }
+    }
+    for (unsigned int i = 0; i < workers; i++) {
+        if (pthread_join(poolThreads[i], NULL)) {
+            mvLog(MVLOG_ERROR, "Waiting for thread failed");
+        }
+    }
+    for (unsigned int i = 0; i < readers; i++) {
+        pooledReader_t* reader = &poolReaders[i];
+        if (pthread_mutex_lock(&pool_mutex) == 0) {
+            reader->link = NULL;
+            pthread_mutex_unlock(&pool_mutex);
+        }
+        if (XLink_sem_post(&reader->startSem)) {
+            mvLog(MVLOG_ERROR, "can't post semaphore\n");
+        }
+        if (pthread_join(reader->threadId, NULL)) {
+            mvLog(MVLOG_ERROR, "Waiting for thread failed");
+        }
+        XLink_sem_destroy(&reader->startSem);
+    }
+    if (workers) {
+        XLink_sem_destroy(&poolRunSem);
+    }
+
+    if (pthread_mutex_lock(&pool_mutex) == 0) {
+        poolThreadsRunning = 0;
+        poolReadersStarted = 0;
+        poolRunHead = 0;
+        poolRunCount = 0;
+        poolStopping = 0;
+        pthread_mutex_unlock(&pool_mutex);
+    }
+}
+
+static int isEventTypeRequest(xLinkEventPriv_t* event)
+{
+    return event->packet.header.type < XLINK_REQUEST_LAST;
+}
+
+static void postAndMarkEventServed(xLinkEventPriv_t *event)
+{
+    if (event->retEv){
+        // the xLinkEventPriv_t slot pointed by "event" will be
+        // re-cycled as soon as we mark it as EVENT_SERVED,
+        // so before that, we copy the result event into XLink API layer
+        *(event->retEv) = event->packet;
+    }
+    if(event->sem){
+        if (XLink_sem_post(event->sem)) {
+            mvLog(MVLOG_ERROR,"can't post semaphore\n");
+        }
+    }
+    traceEvent(event->queue, XLINK_TRACE_EVENT_SERVED, event->origin, &event->packet);
+    if (event->callback) {
+        // called by runEventCallbacks once queueMutex is released, keeping the slot till then
+        setEventState(event, EVENT_COMPLETED);
+        return;
+    }
+    setEventState(event, EVENT_SERVED);
+}
+
+static void postAndMarkEventDropped(xLinkEventPriv_t *event)
+{
+    if (event->callback) {
+        // nobody waits for an asynchronous event, report the failure through it
+        XLINK_EVENT_NOT_ACKNOWLEDGE(&event->packet);
+    }
+    postAndMarkEventServed(event);
+}
+
+// Ids run from 0xb up to INT32_MAX - 1 and wrap around
+static int createUniqueID()
+{
+    uint32_t count = XLink_atomic_fetch_add(&eventIdCounter, 1);
+    return 0xb + (int)(count % (INT32_MAX - 0xb));
+}
+
+int findAvailableScheduler()
+{
     int i;
+    // A cleaned scheduler still uses its slot until its link is reset
     for (i = 0; i < MAX_SCHEDULERS; i++)
-        if (schedulerState[i].schedulerId == -1)
+        if (schedulerState[i].schedulerId == -1 && schedulerState[i].dispatcherLinkDown)
             return i;
     return -1;
 }
@@ -857,6 +1522,19 @@ int findAvailableScheduler()
 static xLinkSchedulerState_t* findCorrespondingScheduler(void* xLinkFD)
 {
     int i;
+    xLinkDesc_t* link = NULL;
+    if (xLinkFD != NULL) {
+        link = getLink(xLinkFD);
+        if (link) {
+            uint32_t hint = XLink_atomic_load(&link->schedulerIndexHint);
+            if (hint < MAX_SCHEDULERS &&
+                schedulerState[hint].schedulerId != -1 &&
+                schedulerState[hint].deviceHandle.xLinkFD == xLinkFD) {
+                return &schedulerState[hint];
+            }
+        }
+    }
+
     XLINK_RET_ERR_IF(pthread_mutex_lock(&num_schedulers_mutex) != 0, NULL);
     if (xLinkFD == NULL) { //in case of myriad there should be one scheduler
         if (numSchedulers == 1) {
@@ -871,7 +1549,10 @@ static xLinkSchedulerState_t* findCorrespondingScheduler(void* xLinkFD)
         if (schedulerState[i].schedulerId != -1 &&
             schedulerState[i].deviceHandle.xLinkFD == xLinkFD) {
             XLINK_RET_ERR_IF(pthread_mutex_unlock(&num_schedulers_mutex) != 0, NULL);
-                return &schedulerState[i];
+            if (link) {
+                XLink_atomic_store(&link->schedulerIndexHint, (uint32_t)i);
+            }
+            return &schedulerState[i];
         }
 
     XLINK_RET_ERR_IF(pthread_mutex_unlock(&num_schedulers_mutex) != 0, NULL);
@@ -882,15 +1563,18 @@ static int dispatcherRequestServe(xLinkEventPriv_t * event, xLinkSchedulerState_
     XLINK_RET_IF(curr == NULL);
     XLINK_RET_IF(!isEventTypeRequest(event));
     xLinkEventHeader_t *header = &event->packet.header;
-    if (header->flags.bitField.block){ //block is requested
-        event->isServed = EVENT_BLOCKED;
+    if (header->flags.bitField.block && event->withdrawn){
+        // nobody waits for it to unblock, the waiter finds the block flag set
+        postAndMarkEventServed(event);
+    } else if (header->flags.bitField.block){ //block is requested
+        setEventState(event, EVENT_BLOCKED);
     } else if(header->flags.bitField.localServe == 1 ||
               (header->flags.bitField.ack == 0
                && header->flags.bitField.nack == 1)){ //this event is served locally, or it is failed
         postAndMarkEventServed(event);
     } else if (header->flags.bitField.ack == 1
               && header->flags.bitField.nack == 0){
-        event->isServed = EVENT_PENDING;
+        setEventState(event, EVENT_PENDING);
         mvLog(MVLOG_DEBUG,"------------------------UNserved %s\n",
               TypeToStr(event->packet.header.type));
     }else{
@@ -903,16 +1587,22 @@ static int dispatcherResponseServe(xLinkEventPriv_t * event, xLinkSchedulerState
 {
     XLINK_RET_ERR_IF(curr == NULL, 1);
     XLINK_RET_ERR_IF(isEventTypeRequest(event), 1);
-    int i = 0;
-    for (i = 0; i < MAX_EVENTS; i++)
+    xLinkEventHeader_t *evHeader = &event->packet.header;
+    xLinkEventPriv_t* pendingEvent;
+    for (pendingEvent = getPendingList(&curr->lQueue, evHeader->id)->head;
+         pendingEvent != NULL;
+         pendingEvent = pendingEvent->next)
     {
-        xLinkEventHeader_t *header = &curr->lQueue.q[i].packet.header;
-        xLinkEventHeader_t *evHeader = &event->packet.header;
+        xLinkEventHeader_t *header = &pendingEvent->packet.header;
 
-        if (curr->lQueue.q[i].isServed == EVENT_PENDING &&
-            header->id == evHeader->id &&
+        if (header->id == evHeader->id &&
             header->type == evHeader->type - XLINK_REQUEST_LAST -1)
         {
+            if (pendingEvent->packet.packetCount > 1) {
+                // batched request, served once the remote answered every packet
+                pendingEvent->packet.packetCount--;
+                break;
+            }
             mvLog(MVLOG_DEBUG,"----------------------ISserved %s\n",
                   TypeToStr(header->type));
             //propagate back flags
@@ -920,14 +1610,14 @@ static int dispatcherResponseServe(xLinkEventPriv_t * event, xLinkSchedulerState
             header->tsecLsb = evHeader->tsecLsb;
             header->tsecMsb = evHeader->tsecMsb;
             header->tnsec = evHeader->tnsec;
-            postAndMarkEventServed(&curr->lQueue.q[i]);
+            postAndMarkEventServed(pendingEvent);
             break;
         }
     }
-    if (i == MAX_EVENTS) {
+    if (pendingEvent == NULL) {
         mvLog(MVLOG_FATAL,"no request for this response: %s %d\n", TypeToStr(event->packet.header.type), event->origin);
         mvLog(MVLOG_DEBUG,"#### (i == MAX_EVENTS) %s %d %d\n", TypeToStr(event->packet.header.type), event->origin, (int)event->packet.header.id);
-        for (i = 0; i < MAX_EVENTS; i++)
+        for (uint32_t i = 0; i < curr->lQueue.capacity; i++)
         {
             xLinkEventHeader_t *header = &curr->lQueue.q[i].packet.header;
 
@@ -940,28 +1630,12 @@ static int dispatcherResponseServe(xLinkEventPriv_t * event, xLinkSchedulerState
     return 0;
 }
 
-static inline xLinkEventPriv_t* getNextElementWithState(xLinkEventPriv_t* base, xLinkEventPriv_t* end,
-                                                        xLinkEventPriv_t* start, xLinkEventState_t state){
-    xLinkEventPriv_t* tmp = start;
-    while (start->isServed != state){
-        CIRCULAR_INCREMENT_BASE(start, end, base);
-        if(tmp == start){
-            break;
-        }
-    }
-    if(start->isServed == state){
-        return start;
-    }else{
-        return NULL;
-    }
-}
-
 static xLinkEventPriv_t* searchForReadyEvent(xLinkSchedulerState_t* curr)
 {
     XLINK_RET_ERR_IF(curr == NULL, NULL);
     xLinkEventPriv_t* ev = NULL;
 
-    ev = getNextElementWithState(curr->lQueue.base, curr->lQueue.end, curr->lQueue.base, EVENT_READY);
+    ev = eventListPop(&curr->lQueue.ready);
     if(ev){
         mvLog(MVLOG_DEBUG,"ready %s %d \n",
               TypeToStr((int)ev->packet.header.type),
@@ -971,13 +1645,7 @@ static xLinkEventPriv_t* searchForReadyEvent(xLinkSchedulerState_t* curr)
 }
 
 static xLinkEventPriv_t* getNextQueueElemToProc(eventQueueHandler_t *q ){
-    xLinkEventPriv_t* event = NULL;
-    if (q->cur != q->curProc) {
-        event = getNextElementWithState(q->base, q->end, q->curProc, EVENT_ALLOCATED);
-        q->curProc = event;
-        CIRCULAR_INCREMENT_BASE(q->curProc, q->end, q->base);
-    }
-    return event;
+    return eventListPop(&q->allocated);
 }
 
 /**
@@ -990,9 +1658,9 @@ static xLinkEvent_t* addNextQueueElemToProc(xLinkSchedulerState_t* curr,
 {
     xLinkEvent_t* ev;
     XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, NULL);
-    xLinkEventPriv_t* eventP = getNextElementWithState(q->base, q->end, q->cur, EVENT_SERVED);
+    xLinkEventPriv_t* eventP = eventListPop(&q->free);
     if (eventP == NULL) {
-        mvLog(MVLOG_ERROR, "getNextElementWithState returned NULL");
+        mvLog(MVLOG_ERROR, "No free event slot in the queue");
         XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, NULL);
         return NULL;
     }
@@ -1000,6 +1668,7 @@ static xLinkEvent_t* addNextQueueElemToProc(xLinkSchedulerState_t* curr,
     ev = &eventP->packet;
 
     eventP->sem = sem;
+    eventP->callback = NULL;
     eventP->packet = *event;
     eventP->origin = o;
     if (o == EVENT_LOCAL) {
@@ -1008,45 +1677,358 @@ static xLinkEvent_t* addNextQueueElemToProc(xLinkSchedulerState_t* curr,
     }else{
         eventP->retEv = NULL;
     }
-    q->cur = eventP;
-    eventP->isServed = EVENT_ALLOCATED;
-    CIRCULAR_INCREMENT_BASE(q->cur, q->end, q->base);
+    setEventState(eventP, EVENT_ALLOCATED);
     XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, NULL);
     return ev;
 }
 
-static xLinkEventPriv_t* dispatcherGetNextEvent(xLinkSchedulerState_t* curr)
+/**
+ * @brief Lock-free submission of a local event
+ * @return 0 on success, 1 if the queue is full
+ */
+static int submitLocalEvent(eventSubmitQueue_t* q, xLinkEvent_t* event,
+                            XLink_sem_t* sem, xLinkEventCallback_t callback)
 {
-    XLINK_RET_ERR_IF(curr == NULL, NULL);
+    eventSubmission_t* cell;
+    uint32_t pos = XLink_atomic_load(&q->enqueuePos);
+    for (;;) {
+        cell = &q->cells[pos % q->capacity];
+        int32_t diff = (int32_t)(XLink_atomic_load(&cell->sequence) - pos);
+        if (diff == 0) {
+            if (XLink_atomic_compare_exchange(&q->enqueuePos, &pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return 1;
+        } else {
+            pos = XLink_atomic_load(&q->enqueuePos);
+        }
+    }
 
-    int rc;
-    while(((rc = XLink_sem_wait(&curr->notifyDispatcherSem)) == -1) && errno == EINTR)
-        continue;
-    if (rc) {
-        mvLog(MVLOG_ERROR,"can't post semaphore\n");
+    cell->packet = *event;
+    // XLink API caller provided buffer for return the final result to,
+    // asynchronous callers don't wait for the event
+    cell->retEv = callback ? NULL : event;
+    cell->sem = sem;
+    cell->callback = callback;
+    cell->withdrawn = 0;
+    XLink_atomic_store(&cell->sequence, pos + 1);
+    return 0;
+}
+
+/**
+ * @brief Moves submitted local events into free lQueue slots
+ * @note Called by the scheduler with queueMutex locked
+ */
+static void moveSubmittedEvents(xLinkSchedulerState_t* curr)
+{
+    eventSubmitQueue_t* q = &curr->submitQueue;
+    while (curr->lQueue.free.head != NULL) {
+        eventSubmission_t* cell = &q->cells[q->dequeuePos % q->capacity];
+        if ((int32_t)(XLink_atomic_load(&cell->sequence) - (q->dequeuePos + 1)) < 0) {
+            break;
+        }
+        if (cell->withdrawn) {
+            XLink_atomic_store(&cell->sequence, q->dequeuePos + q->capacity);
+            q->dequeuePos++;
+            continue;
+        }
+
+        xLinkEventPriv_t* eventP = eventListPop(&curr->lQueue.free);
+        eventP->packet = cell->packet;
+        eventP->retEv = cell->retEv;
+        eventP->sem = cell->sem;
+        eventP->callback = cell->callback;
+        eventP->origin = EVENT_LOCAL;
+        setEventState(eventP, EVENT_ALLOCATED);
+
+        XLink_atomic_store(&cell->sequence, q->dequeuePos + q->capacity);
+        q->dequeuePos++;
     }
+}
+
+/**
+ * @brief Drops the references to a completion from its event, which stays queued.
+ *        Needed when the waiter gives up, as the completion lives on its stack.
+ */
+static int detachCompletion(xLinkSchedulerState_t* curr, xLinkEventCompletion_t* completion)
+{
+    XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, 1);
+    detachCompletionLocked(curr, completion);
+    XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
+    return 0;
+}
 
+static void detachCompletionLocked(xLinkSchedulerState_t* curr, xLinkEventCompletion_t* completion)
+{
+    eventSubmitQueue_t* submitQueue = &curr->submitQueue;
+    for (uint32_t pos = submitQueue->dequeuePos;
+         pos != XLink_atomic_load(&submitQueue->enqueuePos); pos++) {
+        eventSubmission_t* cell = &submitQueue->cells[pos % submitQueue->capacity];
+        if (cell->sem == &completion->sem) {
+            cell->sem = NULL;
+            cell->retEv = NULL;
+        }
+    }
+    for (xLinkEventPriv_t* event = curr->lQueue.q; event < curr->lQueue.q + curr->lQueue.capacity; event++) {
+        if (event->sem == &completion->sem) {
+            event->sem = NULL;
+            event->retEv = NULL;
+        }
+    }
+}
+
+/**
+ * @brief Drops the event of a completion unless the scheduler is processing it,
+ *        in which case it is marked to be served instead of blocked
+ * @return 1 if the event was dropped or is already served, 0 if it was marked
+ */
+static int withdrawEventLocked(xLinkSchedulerState_t* curr, xLinkEventCompletion_t* completion)
+{
+    eventSubmitQueue_t* submitQueue = &curr->submitQueue;
+    for (uint32_t pos = submitQueue->dequeuePos;
+         pos != XLink_atomic_load(&submitQueue->enqueuePos); pos++) {
+        eventSubmission_t* cell = &submitQueue->cells[pos % submitQueue->capacity];
+        if (cell->sem == &completion->sem) {
+            cell->withdrawn = 1;
+            return 1;
+        }
+    }
+    for (xLinkEventPriv_t* event = curr->lQueue.q; event < curr->lQueue.q + curr->lQueue.capacity; event++) {
+        if (event->sem != &completion->sem || event->isServed == EVENT_SERVED) {
+            continue;
+        }
+        mvLog(MVLOG_DEBUG, "withdrawn**************** %d %s\n",
+              (int)event->packet.header.id, TypeToStr((int)event->packet.header.type));
+        if (event->list == NULL) {
+            event->withdrawn = 1;
+            return 0;
+        }
+        setEventState(event, EVENT_SERVED);
+        return 1;
+    }
+    return 1;
+}
+
+/**
+ * @brief Releases the completion once its waiter is done with it
+ * @return 0 if the event was completed, the result of the wait otherwise
+ */
+static int finishCompletion(xLinkSchedulerState_t* curr, xLinkEventCompletion_t* completion, int rc)
+{
+    if (rc && curr != NULL) {
+        detachCompletion(curr, completion);
+        // The event could have been completed before it was detached
+        if (XLink_sem_trywait(&completion->sem) == 0) {
+            rc = 0;
+        }
+    }
+    XLink_sem_destroy(&completion->sem);
+    return rc;
+}
+
+/**
+ * @brief Calls the callbacks of the served asynchronous events in order, by one thread at a time
+ * @note Must be called with queueMutex unlocked, a callback may call XLink functions
+ */
+static void runEventCallbacks(xLinkSchedulerState_t* curr)
+{
+    if (pthread_mutex_lock(&(curr->queueMutex)) != 0) {
+        mvLog(MVLOG_ERROR, "can't lock queueMutex\n");
+        return;
+    }
+    if (curr->callbacksRunning) {
+        // that thread calls the ones queued now as well
+        pthread_mutex_unlock(&(curr->queueMutex));
+        return;
+    }
+    curr->callbacksRunning = 1;
+    xLinkEventPriv_t* event;
+    while ((event = eventListPop(&curr->lQueue.completed)) != NULL) {
+        pthread_mutex_unlock(&(curr->queueMutex));
+        event->callback(&event->packet);
+        pthread_mutex_lock(&(curr->queueMutex));
+        setEventState(event, EVENT_SERVED);
+    }
+    curr->callbacksRunning = 0;
+    pthread_mutex_unlock(&(curr->queueMutex));
+}
+
+/**
+ * @brief Wakes the scheduler up, only if it is waiting for work
+ */
+static void wakeDispatcher(xLinkSchedulerState_t* curr)
+{
+    if (curr->pooled) {
+        scheduleLink(curr);
+        return;
+    }
+    if (XLink_atomic_exchange(&curr->dispatcherIdle, 0)) {
+        if (XLink_sem_post(&curr->notifyDispatcherSem)) {
+            mvLog(MVLOG_ERROR, "can't post semaphore\n");
+        }
+    }
+}
+
+/**
+ * @brief Blocks the event reader while rQueue has no free slot, a remote event
+ *        read meanwhile would have to be dropped
+ */
+static void waitForRemoteSlot(xLinkSchedulerState_t* curr)
+{
+    if (pthread_mutex_lock(&(curr->queueMutex)) != 0) {
+        return;
+    }
+    while (curr->rQueue.free.head == NULL && !curr->resetXLink) {
+        curr->readerWaiting = 1;
+        pthread_mutex_unlock(&(curr->queueMutex));
+        // bounded wait, so a reset is noticed even without a served event
+        while (XLink_sem_timedwait_ms(&curr->remoteSlotSem, 100) == -1 && errno == EINTR)
+            continue;
+        if (pthread_mutex_lock(&(curr->queueMutex)) != 0) {
+            return;
+        }
+    }
+    pthread_mutex_unlock(&(curr->queueMutex));
+}
+
+static xLinkEventPriv_t* takeNextEvent(xLinkSchedulerState_t* curr)
+{
     xLinkEventPriv_t* event = NULL;
     XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, NULL);
+    moveSubmittedEvents(curr);
     event = searchForReadyEvent(curr);
+    if (event == NULL) {
+        eventQueueHandler_t* hPriorityQueue = curr->queueProcPriority ? &curr->lQueue : &curr->rQueue;
+        eventQueueHandler_t* lPriorityQueue = curr->queueProcPriority ? &curr->rQueue : &curr->lQueue;
+        curr->queueProcPriority = curr->queueProcPriority ? 0 : 1;
+
+        event = getNextQueueElemToProc(hPriorityQueue);
+        if (event == NULL) {
+            event = getNextQueueElemToProc(lPriorityQueue);
+        }
+    }
+
+    XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, NULL);
     if (event) {
-        XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, NULL);
-        return event;
+        traceEvent(event->queue, XLINK_TRACE_EVENT_PICKED, event->origin, &event->packet);
+        XLINK_PROBE5(event_dequeue, curr->linkId, event->packet.header.streamId, event->packet.header.id,
+                     event->packet.header.type, event->packet.header.size);
     }
+    return event;
+}
 
-    eventQueueHandler_t* hPriorityQueue = curr->queueProcPriority ? &curr->lQueue : &curr->rQueue;
-    eventQueueHandler_t* lPriorityQueue = curr->queueProcPriority ? &curr->rQueue : &curr->lQueue;
-    curr->queueProcPriority = curr->queueProcPriority ? 0 : 1;
+static void traceEvent(eventQueueHandler_t* q, xLinkTraceStage_t stage,
+                       xLinkEventOrigin_t origin, const xLinkEvent_t* event)
+{
+    if (q->trace) {
+        XLinkTraceRecord(q->trace, stage, origin == EVENT_REMOTE, event->header.type,
+                         event->header.id, event->header.streamId, event->header.size);
+    }
+}
 
-    event = getNextQueueElemToProc(hPriorityQueue);
-    if (event) {
-        XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, NULL);
-        return event;
+/**
+ * @brief Returns the next event to process, sleeping if there is none.
+ *        NULL is returned once there is no work left and dispatcherClean was called.
+ */
+static xLinkEventPriv_t* dispatcherGetNextEvent(xLinkSchedulerState_t* curr)
+{
+    XLINK_RET_ERR_IF(curr == NULL, NULL);
+
+    for (;;) {
+        const int writer = isLinkWriter(curr);
+        if (writer && glControlFunc->flushDeferred &&
+            getMonotonicTimestampMs() >= curr->deferredCheckMs) {
+            flushDeferredWork(curr);
+        }
+        xLinkEventPriv_t* event = takeNextEvent(curr);
+        if (event) {
+            return event;
+        }
+        if (curr->dispatcherCleaning || curr->resetXLink) {
+            if (writer) {
+                flushHeldSends(curr);
+            }
+            return NULL;
+        }
+        unsigned int deferredMs = flushDeferredWork(curr);
+        // nothing else is ready, the writes held back to batch them go out now
+        flushHeldSends(curr);
+
+        // Announce going idle, then check again to not miss work added meanwhile
+        XLink_atomic_store(&curr->dispatcherIdle, 1);
+        event = takeNextEvent(curr);
+        if (event || XLink_atomic_load(&curr->resetXLink)) {
+            if (!XLink_atomic_exchange(&curr->dispatcherIdle, 0)) {
+                // a wakeup is already posted for us, consume it
+                while(XLink_sem_wait(&curr->notifyDispatcherSem) == -1 && errno == EINTR)
+                    continue;
+            }
+            return event;
+        }
+
+        int rc;
+        if (deferredMs == XLINK_NO_RW_TIMEOUT) {
+            while(((rc = XLink_sem_wait(&curr->notifyDispatcherSem)) == -1) && errno == EINTR)
+                continue;
+        } else {
+            // wake up in time for the deferred work
+            while(((rc = XLink_sem_timedwait_ms(&curr->notifyDispatcherSem, deferredMs)) == -1) && errno == EINTR)
+                continue;
+            if (rc == -1 && errno == ETIMEDOUT) {
+                rc = 0;
+            }
+        }
+        if (rc) {
+            mvLog(MVLOG_ERROR,"can't post semaphore\n");
+            return NULL;
+        }
+        XLink_atomic_exchange(&curr->dispatcherIdle, 0);
+        // The wakeup may belong to an event already taken by the fast path,
+        // so go back to sleep if there is nothing to do
     }
-    event = getNextQueueElemToProc(lPriorityQueue);
+}
 
-    XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, NULL);
-    return event;
+/**
+ * @brief Lets the handlers send work they deferred, e.g. coalesced releases
+ * @return Milliseconds until deferred work is due, XLINK_NO_RW_TIMEOUT if there is none
+ */
+static unsigned int flushDeferredWork(xLinkSchedulerState_t* curr)
+{
+    if (glControlFunc->flushDeferred == NULL) {
+        return XLINK_NO_RW_TIMEOUT;
+    }
+    unsigned int dueMs = glControlFunc->flushDeferred(&curr->deviceHandle);
+    // while busy, poll once per millisecond for work deferred meanwhile
+    curr->deferredCheckMs = getMonotonicTimestampMs() + (dueMs == XLINK_NO_RW_TIMEOUT ? 1 : dueMs);
+    return dueMs;
+}
+
+/**
+ * @brief Writes the events held back by eventSend, resetting the link if that fails
+ */
+static void flushHeldSends(xLinkSchedulerState_t* curr)
+{
+    if (glControlFunc->flushSends == NULL || glControlFunc->flushSends(&curr->deviceHandle) == 0) {
+        return;
+    }
+    curr->resetXLink = 1;
+    if (pthread_mutex_lock(&(curr->queueMutex)) == 0) {
+        dispatcherFreeEvents(&curr->lQueue, EVENT_PENDING);
+        dispatcherFreeEvents(&curr->lQueue, EVENT_BLOCKED);
+        pthread_mutex_unlock(&(curr->queueMutex));
+    }
+    mvLog(MVLOG_ERROR, "Event sending failed");
+}
+
+/**
+ * @brief Only the thread serving the link writes to it. dispatcherClean may drain
+ *        the queues from an API thread meanwhile, which must leave the sends alone.
+ */
+static int isLinkWriter(xLinkSchedulerState_t* curr)
+{
+    return !curr->dispatcherCleaning ||
+           (!curr->pooled && pthread_equal(pthread_self(), curr->xLinkThreadId));
 }
 
 static int dispatcherClean(xLinkSchedulerState_t* curr)
@@ -1063,6 +2045,7 @@ static int dispatcherClean(xLinkSchedulerState_t* curr)
 
     mvLog(MVLOG_INFO, "Start Clean Dispatcher...");
 
+    curr->dispatcherCleaning = 1;
     if (XLink_sem_post(&curr->notifyDispatcherSem)) {
         mvLog(MVLOG_ERROR,"can't post semaphore\n"); //to allow us to get a NULL event
     }
@@ -1072,7 +2055,7 @@ static int dispatcherClean(xLinkSchedulerState_t* curr)
               TypeToStr(event->packet.header.type), event->isServed);
 
         XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, 1);
-        postAndMarkEventServed(event);
+        postAndMarkEventDropped(event);
         XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
         event = dispatcherGetNextEvent(curr);
     }
@@ -1084,15 +2067,11 @@ static int dispatcherClean(xLinkSchedulerState_t* curr)
 
     curr->schedulerId = -1;
     curr->resetXLink = 1;
-    XLink_sem_destroy(&curr->addEventSem);
-    XLink_sem_destroy(&curr->notifyDispatcherSem);
-    localSem_t* temp = curr->eventSemaphores;
-    while (temp < curr->eventSemaphores + MAXIMUM_SEMAPHORES) {
-        // unblock potentially blocked event semaphores
-        XLink_sem_post(&temp->sem);
-        XLink_sem_destroy(&temp->sem);
-        temp++;
+    if (curr->pooled) {
+        // let a worker close the link, there is no scheduler thread to notice
+        scheduleLink(curr);
     }
+    XLink_sem_destroy(&curr->notifyDispatcherSem);
     numSchedulers--;
 
     XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, 1);
@@ -1101,6 +2080,8 @@ static int dispatcherClean(xLinkSchedulerState_t* curr)
     if(pthread_mutex_unlock(&clean_mutex) != 0) {
         mvLog(MVLOG_ERROR, "Failed to unlock clean_mutex after clearing dispatcher");
     }
+    // the dropped asynchronous events report their failure
+    runEventCallbacks(curr);
     XLINK_RET_ERR_IF(pthread_mutex_destroy(&(curr->queueMutex)) != 0, 1);
     return 0;
 }
@@ -1172,12 +2153,13 @@ static int dispatcherReset(xLinkSchedulerState_t* curr)
 }
 
 static XLinkError_t sendEvents(xLinkSchedulerState_t* curr) {
-    int res;
     xLinkEventPriv_t* event;
-    xLinkEventPriv_t response;
 
     while (!curr->resetXLink) {
         event = dispatcherGetNextEvent(curr);
+        if(event == NULL && curr->resetXLink) {
+            break; // the link went down while waiting
+        }
         if(event == NULL) {
             mvLog(MVLOG_ERROR,"Dispatcher received NULL event!");
 #ifndef __DEVICE__
@@ -1186,93 +2168,125 @@ static XLinkError_t sendEvents(xLinkSchedulerState_t* curr) {
             continue;
 #endif
         }
-        
-        if(event->packet.deviceHandle.xLinkFD
-           != curr->deviceHandle.xLinkFD) {
-            mvLog(MVLOG_FATAL,"The file descriptor mismatch between the event and the scheduler.\n"
-                              "    Event: id=%d, fd=%p"
-                              "    Scheduler fd=%p",
-                              event->packet.header.id, event->packet.deviceHandle.xLinkFD,
-                              curr->deviceHandle.xLinkFD);
-            event->packet.header.flags.bitField.nack = 1;
-            event->packet.header.flags.bitField.ack = 0;
-
-            XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
-            if (event->origin == EVENT_LOCAL){
-                dispatcherRequestServe(event, curr);
-            } else {
-                dispatcherResponseServe(event, curr);
-            }
-            XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
 
-            continue;
+        XLinkError_t rc = serveEvent(curr, event);
+        if (rc) {
+            return rc;
         }
+    }
+    // e.g. the reset request
+    flushHeldSends(curr);
+
+    return X_LINK_SUCCESS;
+}
 
-        getRespFunction getResp;
-        xLinkEvent_t* toSend;
+/**
+ * @brief Handles one event taken off the link's queues, sending what it requires
+ */
+static XLinkError_t serveEvent(xLinkSchedulerState_t* curr, xLinkEventPriv_t* event) {
+    int res;
+    xLinkEventPriv_t response;
+
+    if(event->packet.deviceHandle.xLinkFD
+       != curr->deviceHandle.xLinkFD) {
+        mvLog(MVLOG_FATAL,"The file descriptor mismatch between the event and the scheduler.\n"
+                          "    Event: id=%d, fd=%p"
+                          "    Scheduler fd=%p",
+                          event->packet.header.id, event->packet.deviceHandle.xLinkFD,
+                          curr->deviceHandle.xLinkFD);
+        event->packet.header.flags.bitField.nack = 1;
+        event->packet.header.flags.bitField.ack = 0;
+
+        XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
         if (event->origin == EVENT_LOCAL){
-            getResp = glControlFunc->localGetResponse;
-            toSend = &event->packet;
-        }else{
-            getResp = glControlFunc->remoteGetResponse;
-            toSend = &response.packet;
-        }
-
-        res = getResp(&event->packet, &response.packet);
-
-        if (isEventTypeRequest(event)) {
-            XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
-            if (event->origin == EVENT_LOCAL) { //we need to do this for locals only
-                if(dispatcherRequestServe(event, curr)) {
-                    mvLog(MVLOG_ERROR, "Failed to serve local event. "
-                                       "Event: id=%d, type=%s, streamId=%u, streamName=%s",
-                                       event->packet.header.id,  TypeToStr(event->packet.header.type),
-                                       event->packet.header.streamId, event->packet.header.streamName);
-                }
+            dispatcherRequestServe(event, curr);
+        } else {
+            dispatcherResponseServe(event, curr);
+        }
+        XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+
+        return X_LINK_SUCCESS;
+    }
+
+    getRespFunction getResp;
+    xLinkEvent_t* toSend;
+    if (event->origin == EVENT_LOCAL){
+        getResp = glControlFunc->localGetResponse;
+        toSend = &event->packet;
+    }else{
+        getResp = glControlFunc->remoteGetResponse;
+        toSend = &response.packet;
+    }
+
+    res = getResp(&event->packet, &response.packet);
+
+    if (isEventTypeRequest(event)) {
+        XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+        if (event->origin == EVENT_LOCAL) { //we need to do this for locals only
+            if(dispatcherRequestServe(event, curr)) {
+                mvLog(MVLOG_ERROR, "Failed to serve local event. "
+                                   "Event: id=%d, type=%s, streamId=%u, streamName=%s",
+                                   event->packet.header.id,  TypeToStr(event->packet.header.type),
+                                   event->packet.header.streamId, event->packet.header.streamName);
             }
+        }
 
-            if (res == 0 && event->packet.header.flags.bitField.localServe == 0) {
+        if (res == 0 && event->packet.header.flags.bitField.localServe == 0) {
 #ifndef __DEVICE__
-                if (toSend->header.type == XLINK_RESET_REQ) {
-                    curr->resetXLink = 1;
-                    mvLog(MVLOG_DEBUG,"Send XLINK_RESET_REQ, stopping sendEvents thread.");
-                    if(toSend->deviceHandle.protocol == X_LINK_PCIE) {
-                        toSend->header.type = XLINK_PING_REQ;
-                        mvLog(MVLOG_DEBUG, "Request for reboot not sent, only ping event");
-                    } else {
+            if (toSend->header.type == XLINK_RESET_REQ) {
+                curr->resetXLink = 1;
+                mvLog(MVLOG_DEBUG,"Send XLINK_RESET_REQ, stopping sendEvents thread.");
+                if(toSend->deviceHandle.protocol == X_LINK_PCIE) {
+                    toSend->header.type = XLINK_PING_REQ;
+                    mvLog(MVLOG_DEBUG, "Request for reboot not sent, only ping event");
+                } else {
 #if defined(NO_BOOT)
-                        toSend->header.type = XLINK_PING_REQ;
-                        mvLog(MVLOG_INFO, "Request for reboot not sent, only ping event");
+                    toSend->header.type = XLINK_PING_REQ;
+                    mvLog(MVLOG_INFO, "Request for reboot not sent, only ping event");
 #endif // defined(NO_BOOT)
 
-                    }
                 }
+            }
 #endif // __DEVICE__
+            XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+            traceEvent(event->queue, XLINK_TRACE_SEND_BEGIN, event->origin, toSend);
+            int sendRc = glControlFunc->eventSend(toSend);
+            traceEvent(event->queue, XLINK_TRACE_SEND_END, event->origin, toSend);
+            if (sendRc != 0) {
+                // Error out
+                curr->resetXLink = 1;
+                XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+                dispatcherFreeEvents(&curr->lQueue, EVENT_PENDING);
+                dispatcherFreeEvents(&curr->lQueue, EVENT_BLOCKED);
                 XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
-                if (glControlFunc->eventSend(toSend) != 0) {
-                    // Error out
-                    curr->resetXLink = 1;
-                    XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
-                    dispatcherFreeEvents(&curr->lQueue, EVENT_PENDING);
-                    dispatcherFreeEvents(&curr->lQueue, EVENT_BLOCKED);
-                    XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
-                    mvLog(MVLOG_ERROR, "Event sending failed");
-                }
-            } else {
-                XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+                mvLog(MVLOG_ERROR, "Event sending failed");
             }
         } else {
-            XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
-            if (event->origin == EVENT_REMOTE){ // match remote response with the local request
-                dispatcherResponseServe(event, curr);
-            }
             XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
         }
-
-        if (event->origin == EVENT_REMOTE){
-            event->isServed = EVENT_SERVED;
+    } else {
+        XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+        if (event->origin == EVENT_REMOTE){ // match remote response with the local request
+            dispatcherResponseServe(event, curr);
+        }
+        XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+    }
+
+    if (event->origin == EVENT_REMOTE){
+        traceEvent(event->queue, XLINK_TRACE_EVENT_SERVED, event->origin, &event->packet);
+        XLINK_RET_ERR_IF(pthread_mutex_lock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
+        setEventState(event, EVENT_SERVED);
+        if (curr->readerWaiting) {
+            curr->readerWaiting = 0;
+            if (curr->reactorActive) {
+                XLinkReactorResume(&curr->reactorSource);
+            } else if (XLink_sem_post(&curr->remoteSlotSem)) {
+                mvLog(MVLOG_ERROR, "can't post semaphore\n");
+            }
         }
+        XLINK_RET_ERR_IF(pthread_mutex_unlock(&(curr->queueMutex)) != 0, X_LINK_ERROR);
     }
+    runEventCallbacks(curr);
 
     return X_LINK_SUCCESS;
 }
@@ -1282,14 +2296,204 @@ static void dispatcherFreeEvents(eventQueueHandler_t *queue, xLinkEventState_t s
         return;
     }
 
-    xLinkEventPriv_t* event = getNextElementWithState(queue->base, queue->end, queue->base, state);
-    while (event != NULL) {
-        mvLog(MVLOG_DEBUG, "Event is %s, size is %d, Mark it served\n", TypeToStr(event->packet.header.type), event->packet.header.size);
-        postAndMarkEventServed(event);
-        event = getNextElementWithState(queue->base, queue->end, queue->base, state);
+    eventList_t* lists = NULL;
+    int listsCount = 1;
+    switch (state) {
+        case EVENT_PENDING:
+            lists = queue->pending;
+            listsCount = EVENT_INDEX_SIZE;
+            break;
+        case EVENT_BLOCKED:
+            lists = queue->blocked;
+            listsCount = EVENT_INDEX_SIZE;
+            break;
+        case EVENT_READY:
+            lists = &queue->ready;
+            break;
+        case EVENT_ALLOCATED:
+            lists = &queue->allocated;
+            break;
+        default:
+            return;
+    }
+
+    for (int i = 0; i < listsCount; i++) {
+        xLinkEventPriv_t* event;
+        while ((event = lists[i].head) != NULL) {
+            mvLog(MVLOG_DEBUG, "Event is %s, size is %d, Mark it served\n", TypeToStr(event->packet.header.type), event->packet.header.size);
+            postAndMarkEventDropped(event);
+        }
+    }
+}
+
+// Storage stays with the scheduler slot, reallocated when a link needs a different capacity
+static int reserveEventStorage(xLinkSchedulerState_t* curr, uint32_t capacity)
+{
+    if (curr->lQueue.q && curr->lQueue.capacity == capacity) {
+        return 0;
+    }
+    free(curr->lQueue.q);
+    free(curr->rQueue.q);
+    free(curr->submitQueue.cells);
+    curr->lQueue.q = calloc(capacity, sizeof(xLinkEventPriv_t));
+    curr->rQueue.q = calloc(capacity, sizeof(xLinkEventPriv_t));
+    curr->submitQueue.cells = calloc(capacity, sizeof(eventSubmission_t));
+    curr->lQueue.capacity = capacity;
+    if (curr->lQueue.q == NULL || curr->rQueue.q == NULL || curr->submitQueue.cells == NULL) {
+        free(curr->lQueue.q);
+        free(curr->rQueue.q);
+        free(curr->submitQueue.cells);
+        curr->lQueue.q = NULL;
+        curr->rQueue.q = NULL;
+        curr->submitQueue.cells = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void initEventQueue(eventQueueHandler_t* q, xLinkEventPriv_t* events, uint32_t capacity)
+{
+    memset(q, 0, sizeof(*q));
+    memset(events, 0, sizeof(xLinkEventPriv_t) * capacity);
+    q->q = events;
+    q->capacity = capacity;
+    for (uint32_t i = 0; i < capacity; i++) {
+        q->q[i].queue = q;
+        q->q[i].isServed = EVENT_SERVED;
+        eventListPush(&q->free, &q->q[i]);
+    }
+}
+
+static void eventListPush(eventList_t* list, xLinkEventPriv_t* event)
+{
+    event->next = NULL;
+    event->list = list;
+    if (list->tail) {
+        list->tail->next = event;
+    } else {
+        list->head = event;
+    }
+    list->tail = event;
+}
+
+// Sequences are compared as serial numbers, the queue never holds events 2^31 apart
+static int isSequenceBefore(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+static void eventListInsertBySequence(eventList_t* list, xLinkEventPriv_t* event)
+{
+    if (list->tail == NULL || isSequenceBefore(list->tail->sequence, event->sequence)) {
+        eventListPush(list, event);
+        return;
+    }
+    xLinkEventPriv_t** link = &list->head;
+    while (isSequenceBefore((*link)->sequence, event->sequence)) {
+        link = &(*link)->next;
     }
+    event->next = *link;
+    event->list = list;
+    *link = event;
 }
 
+static xLinkEventPriv_t* eventListPop(eventList_t* list)
+{
+    xLinkEventPriv_t* event = list->head;
+    if (event) {
+        list->head = event->next;
+        if (list->head == NULL) {
+            list->tail = NULL;
+        }
+        event->next = NULL;
+        event->list = NULL;
+    }
+    return event;
+}
+
+static void eventListRemove(xLinkEventPriv_t* event)
+{
+    eventList_t* list = event->list;
+    if (list == NULL) {
+        return;
+    }
+
+    // lists are short, the index spreads events over many of them
+    xLinkEventPriv_t* prev = NULL;
+    xLinkEventPriv_t* curr = list->head;
+    while (curr != NULL && curr != event) {
+        prev = curr;
+        curr = curr->next;
+    }
+    if (curr == NULL) {
+        mvLog(MVLOG_ERROR, "Event is not linked into its list\n");
+        return;
+    }
+
+    if (prev) {
+        prev->next = event->next;
+    } else {
+        list->head = event->next;
+    }
+    if (list->tail == event) {
+        list->tail = prev;
+    }
+    event->next = NULL;
+    event->list = NULL;
+}
+
+static eventList_t* getPendingList(eventQueueHandler_t* q, eventId_t id)
+{
+    return &q->pending[(uint32_t)id % EVENT_INDEX_SIZE];
+}
+
+static eventList_t* getBlockedList(eventQueueHandler_t* q, streamId_t streamId, xLinkEventType_t type)
+{
+    return &q->blocked[((uint32_t)streamId * 31u + (uint32_t)type) % EVENT_INDEX_SIZE];
+}
+
+/**
+ * @brief Moves the event to the list of its new state
+ * @note Must be called with queueMutex locked
+ */
+static void setEventState(xLinkEventPriv_t* event, xLinkEventState_t state)
+{
+    eventQueueHandler_t* q = event->queue;
+
+    eventListRemove(event);
+    event->isServed = state;
+
+    switch (state) {
+        case EVENT_SERVED:
+            eventListPush(&q->free, event);
+            break;
+        case EVENT_ALLOCATED:
+            event->sequence = q->nextSequence++;
+            event->withdrawn = 0;
+            eventListPush(&q->allocated, event);
+            break;
+        case EVENT_READY:
+            eventListPush(&q->ready, event);
+            break;
+        case EVENT_COMPLETED:
+            eventListPush(&q->completed, event);
+            break;
+        case EVENT_PENDING:
+            eventListPush(getPendingList(q, event->packet.header.id), event);
+            break;
+        case EVENT_BLOCKED:
+            // an unblocked event can get blocked again, it stays ahead of later ones
+            eventListInsertBySequence(getBlockedList(q, event->packet.header.streamId, event->packet.header.type), event);
+            break;
+    }
+}
+
+static int isEventMatching(xLinkEventPriv_t* event, eventId_t id, xLinkEventType_t type, streamId_t stream)
+{
+    return (event->packet.header.id == id || id == -1)
+        && event->packet.header.type == type
+        && event->packet.header.streamId == stream;
+}
 
 // ------------------------------------
 // Helpers implementation. End.
@@ -12,6 +12,8 @@
 #include "XLinkPrivateFields.h"
 
 #include "XLinkTime.h"
+#include "XLinkProbes.h"
+#include "XLinkAtomic.h"
 
 #ifdef MVLOG_UNIT_NAME
 #undef MVLOG_UNIT_NAME
@@ -32,8 +34,75 @@ static streamPacketDesc_t* getPacketFromStream(streamDesc_t* stream);
 static int releasePacketFromStream(streamDesc_t* stream, uint32_t* releasedSize);
 static int releaseSpecificPacketFromStream(streamDesc_t* stream, uint32_t* releasedSize, uint8_t* data);
 static int addNewPacketToStream(streamDesc_t* stream, void* buffer, uint32_t size, XLinkTimespec trsend, XLinkTimespec treceive);
+static void* allocatePacketData(streamDesc_t* stream, xLinkDeviceHandle_t* deviceHandle, uint32_t size);
+static void deallocatePacketData(streamDesc_t* stream, void* data, uint32_t size);
+static int getReadBufferIndex(streamDesc_t* stream, void* data);
+
+static int isCompactHeaderType(xLinkEventType_t type);
+static int isCompactHeader(const xLinkEventHeader_t* header);
+static void packCompactHeader(const xLinkEventHeader_t* header, xLinkCompactEventHeader_t* compactHeader);
+static void unpackCompactHeader(const xLinkCompactEventHeader_t* compactHeader, xLinkEventHeader_t* header);
+// Returns the number of buffers, 1 or 2, the header is written from
+static int setHeaderIoVec(xLinkEventHeader_t* header, int compact,
+                          xLinkCompactEventHeader_t* compactHeader, xLinkPlatformIoVec_t* iov);
+static uint32_t getHeaderSize(xLinkDesc_t* link, const xLinkEventHeader_t* header, uint32_t received);
+static int readEventHeader(xLinkDesc_t* link, xLinkEvent_t* event);
+static int receiveEventPartial(xLinkDesc_t* link, xLinkEvent_t* event, xLinkEventReceiveState_t* state);
+static void noteHeaderFormat(xLinkDesc_t* link, const xLinkEventHeader_t* header);
+
+static int handleIncomingEvent(xLinkDesc_t* link, xLinkEvent_t* event, XLinkTimespec treceive);
+// Both return 0 on success, acknowledge the event negatively on failure
+static int beginIncomingData(xLinkEvent_t* event, streamDesc_t** stream, void** buffer);
+static int completeIncomingData(xLinkEvent_t* event, streamDesc_t* stream, void* buffer,
+                                int readRc, XLinkTimespec treceive);
+
+static void traceHeaderReceived(xLinkEvent_t* event);
+static int isReleaseCoalescing(xLinkDesc_t* link);
+static void addReleaseCredit(xLinkDesc_t* link, xLinkEvent_t* event,
+                             streamDesc_t* stream, uint32_t packets);
+static int flushReleaseCredits(xLinkDeviceHandle_t* deviceHandle, streamDesc_t* stream);
+
+#if XLINK_SEND_BATCH_BYTES < XLINK_PLATFORM_MAX_IOV * XLINK_SEND_BATCH_COPY_SIZE
+#error "XLINK_SEND_BATCH_BYTES must hold the copied parts of any event"
+#endif
 
-static int handleIncomingEvent(xLinkEvent_t* event, XLinkTimespec treceive);
+/**
+ * @brief Events written by the scheduler and held back, to hand several to the transport at once
+ */
+typedef struct xLinkSendBatch_t {
+    int iovCount;
+    uint32_t events;
+    uint32_t stagingBytes;
+    xLinkPlatformIoVec_t iov[XLINK_PLATFORM_MAX_IOV];
+    uint8_t staging[XLINK_SEND_BATCH_BYTES]; // copies of the small parts
+} xLinkSendBatch_t;
+
+// Whether events of the link are written and read several per transfer
+static int isTransferBatched(xLinkDesc_t* link, xLinkDeviceHandle_t* deviceHandle);
+// NULL if the link's events are written right away
+static xLinkSendBatch_t* getSendBatch(xLinkDesc_t* link, xLinkDeviceHandle_t* deviceHandle);
+// Writes the parts of an event, or adds them to the batch. Negative on error
+static int writeEventParts(xLinkSendBatch_t* batch, xLinkDeviceHandle_t* deviceHandle,
+                           const xLinkPlatformIoVec_t* iov, int count);
+static int flushSendBatch(xLinkSendBatch_t* batch, xLinkDeviceHandle_t* deviceHandle);
+
+/**
+ * @brief Bytes read off a link ahead of the event being received
+ */
+typedef struct xLinkRecvBuffer_t {
+    uint32_t start; // first byte not taken yet
+    uint32_t end;
+    uint8_t data[XLINK_RECV_BUFFER_BYTES];
+} xLinkRecvBuffer_t;
+
+// NULL if the link is read exactly as much as each event needs
+static xLinkRecvBuffer_t* getRecvBuffer(xLinkDesc_t* link, xLinkDeviceHandle_t* deviceHandle);
+// Blocking, 0 once size bytes are read
+static int readLinkData(xLinkDesc_t* link, xLinkDeviceHandle_t* deviceHandle, void* data, uint32_t size);
+// Bytes read, up to size, 0 if nothing is pending
+static int readLinkDataNonBlocking(xLinkDesc_t* link, xLinkDeviceHandle_t* deviceHandle, void* data, uint32_t size);
+static int fillRecvBuffer(xLinkRecvBuffer_t* buffer, xLinkDeviceHandle_t* deviceHandle);
+static uint32_t takeRecvBuffer(xLinkRecvBuffer_t* buffer, void* data, uint32_t size);
 
 // ------------------------------------
 // Helpers declaration. End.
@@ -56,21 +125,58 @@ int dispatcherEventSend(xLinkEvent_t *event)
     event->header.tsecLsb = (uint32_t)stime.tv_sec;
     event->header.tsecMsb = (uint32_t)(stime.tv_sec >> 32);
     event->header.tnsec = (uint32_t)stime.tv_nsec;
-    int rc = XLinkPlatformWrite(&event->deviceHandle,
-        &event->header, sizeof(event->header));
 
-    if(rc < 0) {
-        mvLog(MVLOG_ERROR,"Write failed (header) (err %d) | event %s\n", rc, TypeToStr(event->header.type));
-        return rc;
-    }
+    xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+    const int compact = link != NULL && XLink_atomic_load(&link->compactHeaderTx);
+    xLinkSendBatch_t* batch = getSendBatch(link, &event->deviceHandle);
+    xLinkCompactEventHeader_t compactHeader;
+    xLinkPlatformIoVec_t iov[3];
 
     if (event->header.type == XLINK_WRITE_REQ) {
-        rc = XLinkPlatformWrite(&event->deviceHandle,
-            event->data, event->header.size);
+        // Header and payload leave together, in a single call where the transport allows it
+        int count = setHeaderIoVec(&event->header, compact, &compactHeader, iov);
+        iov[count].data = event->data;
+        iov[count].size = (int)event->header.size;
+        int rc = writeEventParts(batch, &event->deviceHandle, iov, count + 1);
         if(rc < 0) {
             mvLog(MVLOG_ERROR,"Write failed %d\n", rc);
             return rc;
         }
+        return 0;
+    }
+
+    if (event->header.type == XLINK_READ_REL_REQ && event->packetCount) {
+        // Batched release to a remote without coalesced releases:
+        // one standard release header per packet, written together
+        const uint32_t* releasedSizes = (const uint32_t*)event->data;
+        xLinkEventHeader_t headers[XLINK_PLATFORM_MAX_IOV];
+        xLinkCompactEventHeader_t compactHeaders[XLINK_PLATFORM_MAX_IOV];
+        xLinkPlatformIoVec_t releaseIov[XLINK_PLATFORM_MAX_IOV];
+        uint32_t sent = 0;
+        while (sent < event->packetCount) {
+            int count = 0;
+            while (count < XLINK_PLATFORM_MAX_IOV && sent < event->packetCount) {
+                headers[count] = event->header;
+                headers[count].size = releasedSizes[sent++];
+                // a release is a single buffer in either format
+                setHeaderIoVec(&headers[count], compact, &compactHeaders[count], &releaseIov[count]);
+                count++;
+            }
+            int rc = writeEventParts(batch, &event->deviceHandle, releaseIov, count);
+            if(rc < 0) {
+                mvLog(MVLOG_ERROR,"Write failed (batched release) (err %d)\n", rc);
+                return rc;
+            }
+        }
+        return 0;
+    }
+
+    int count = setHeaderIoVec(&event->header, compact, &compactHeader, iov);
+    int rc = writeEventParts(batch, &event->deviceHandle, iov, count);
+
+    if(rc < 0) {
+        mvLog(MVLOG_ERROR,"Write failed (header) (err %d) | event %s\n", rc, TypeToStr(event->header.type));
+        return rc;
     }
 
     return 0;
@@ -78,10 +184,14 @@ int dispatcherEventSend(xLinkEvent_t *event)
 
 int dispatcherEventReceive(xLinkEvent_t* event){
     // static xLinkEvent_t prevEvent = {0};
-    int rc = XLinkPlatformRead(&event->deviceHandle,
-        &event->header, sizeof(event->header));
+    xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+    int rc = readEventHeader(link, event);
     XLinkTimespec treceive;
     getMonotonicTimestamp(&treceive);
+    if(rc >= 0) {
+        noteHeaderFormat(link, &event->header);
+        traceHeaderReceived(event);
+    }
 
     // mvLog(MVLOG_DEBUG,"Incoming event %p: %s %d %p prevEvent: %s %d %p\n",
     //       event,
@@ -105,7 +215,24 @@ int dispatcherEventReceive(xLinkEvent_t* event){
     // }
     // prevEvent = *event;
 
-    return handleIncomingEvent(event, treceive);
+    return handleIncomingEvent(link, event, treceive);
+}
+
+int dispatcherEventReceivePartial(xLinkEvent_t* event, xLinkEventReceiveState_t* state)
+{
+    xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+    int rc = receiveEventPartial(link, event, state);
+    state->pendingBytes = link && link->recvBuffer ? link->recvBuffer->end - link->recvBuffer->start : 0;
+    return rc;
+}
+
+void dispatcherEventReceiveCancel(xLinkEvent_t* event, xLinkEventReceiveState_t* state)
+{
+    if(state->stream != NULL) {
+        completeIncomingData(event, (streamDesc_t*)state->stream, state->data, -1, state->treceive);
+    }
+    state->headerBytes = 0;
+    state->stream = NULL;
 }
 
 //this function should be called only for local requests
@@ -132,6 +259,7 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
             if (stream->writeSize == 0)
             {
                 XLINK_EVENT_NOT_ACKNOWLEDGE(event);
+                XLink_atomic_fetch_add_64(&stream->stats.nacks, 1);
                 // return -1 to don't even send it to the remote
                 releaseStream(stream);
                 return -1;
@@ -139,16 +267,34 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
             XLINK_EVENT_ACKNOWLEDGE(event);
             event->header.flags.bitField.localServe = 0;
 
-            if(!isStreamSpaceEnoughFor(stream, event->header.size)){
+            // a write which was blocked before is unblocked in order, a new one
+            // has to queue up behind the blocked ones to keep the data in order
+            const uint32_t wasBlocked = event->header.flags.bitField.block;
+            if((!wasBlocked && stream->blockedWrites) ||
+               !isStreamSpaceEnoughFor(stream, event->header.size)){
                 mvLog(MVLOG_DEBUG,"local NACK RTS. stream '%s' is full (event %d)\n", stream->name, event->header.id);
                 event->header.flags.bitField.block = 1;
                 event->header.flags.bitField.localServe = 1;
-                // TODO: easy to implement non-blocking read here, just return nack
-                mvLog(MVLOG_WARN, "Blocked event would cause dispatching thread to wait on semaphore infinitely\n");
+                if (!wasBlocked && stream->blockedWrites++ == 0) {
+                    stream->stats.writeBlockedSinceUs = getMonotonicTimestampUs();
+                }
             }else{
+                if (wasBlocked) {
+                    stream->blockedWrites--;
+                    if (stream->blockedWrites) {
+                        // there may be space left for the next one as well
+                        DispatcherUnblockEvent(-1, XLINK_WRITE_REQ, event->header.streamId,
+                                               event->deviceHandle.xLinkFD);
+                    } else {
+                        XLinkStreamEndBlocked(&stream->stats.writeBlockedSinceUs,
+                                              &stream->stats.blockedWriteUs);
+                    }
+                }
                 event->header.flags.bitField.block = 0;
                 stream->remoteFillLevel += event->header.size;
                 stream->remoteFillPacketLevel++;
+                XLink_atomic_fetch_add_64(&stream->stats.packetsOut, 1);
+                XLink_atomic_fetch_add_64(&stream->stats.bytesOut, event->header.size);
                 mvLog(MVLOG_DEBUG,"S%d: Got local write of %ld , remote fill level %ld out of %ld %ld\n",
                       event->header.streamId, event->header.size, stream->remoteFillLevel, stream->writeSize, stream->readSize);
             }
@@ -164,6 +310,29 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
                 break;
             }
 
+            if (event->packetCount) {
+                // batched read: drain whatever is already queued, block only when nothing is
+                streamPacketDesc_t** packets = (streamPacketDesc_t**)event->data;
+                uint32_t count = 0;
+                while (count < event->packetCount &&
+                       (packets[count] = getPacketFromStream(stream)) != NULL) {
+                    count++;
+                }
+                if (count) {
+                    event->packetCount = count;
+                    XLINK_EVENT_ACKNOWLEDGE(event);
+                    event->header.flags.bitField.block = 0;
+                } else {
+                    event->header.flags.bitField.block = 1;
+                    if (stream->stats.readBlockedSinceUs == 0) {
+                        stream->stats.readBlockedSinceUs = getMonotonicTimestampUs();
+                    }
+                }
+                event->header.flags.bitField.localServe = 1;
+                releaseStream(stream);
+                break;
+            }
+
             streamPacketDesc_t* packet;
             if (event->header.flags.bitField.moveSemantic) {
                 packet = movePacketFromStream(stream);
@@ -180,6 +349,9 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
             }
             else{
                 event->header.flags.bitField.block = 1;
+                if (stream->stats.readBlockedSinceUs == 0) {
+                    stream->stats.readBlockedSinceUs = getMonotonicTimestampUs();
+                }
                 // TODO: easy to implement non-blocking read here, just return nack
             }
             event->header.flags.bitField.localServe = 1;
@@ -191,9 +363,41 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
             stream = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
             ASSERT_XLINK(stream);
             XLINK_EVENT_ACKNOWLEDGE(event);
-            uint32_t releasedSize = 0;
-            releasePacketFromStream(stream, &releasedSize);
-            event->header.size = releasedSize;
+            uint32_t releasedPackets = 0;
+            if (event->packetCount) {
+                // batched release: sizes of the released packets go to event->data
+                uint32_t* releasedSizes = (uint32_t*)event->data;
+                uint32_t count = 0;
+                uint32_t totalSize = 0;
+                while (count < event->packetCount && stream->blockedPackets) {
+                    releasePacketFromStream(stream, &releasedSizes[count]);
+                    totalSize += releasedSizes[count];
+                    count++;
+                }
+                if (count < event->packetCount) {
+                    mvLog(MVLOG_ERROR, "Released %u out of %u packets, no more packets to release\n",
+                          count, event->packetCount);
+                }
+                event->packetCount = count;
+                event->header.size = totalSize;
+                if (count == 0) {
+                    event->header.flags.bitField.localServe = 1;
+                }
+                releasedPackets = count;
+            } else {
+                uint32_t releasedSize = 0;
+                releasedPackets = stream->blockedPackets ? 1 : 0;
+                releasePacketFromStream(stream, &releasedSize);
+                event->header.size = releasedSize;
+            }
+            xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+            // Acknowledged to the remote later, together with other releases.
+            // Without coalescing a batch still goes out right away as one coalesced release
+            if (releasedPackets && link && (isReleaseCoalescing(link) ||
+                (releasedPackets > 1 && (link->peer.features & XLINK_FEATURE_RELEASE_COALESCING)))) {
+                event->header.flags.bitField.localServe = 1;
+                addReleaseCredit(link, event, stream, releasedPackets);
+            }
             releaseStream(stream);
             break;
         }
@@ -231,6 +435,9 @@ int dispatcherLocalEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response)
 
             ASSERT_XLINK(stream);
             XLINK_EVENT_ACKNOWLEDGE(event);
+            if (stream->releaseCreditPackets) {
+                flushReleaseCredits(&event->deviceHandle, stream);
+            }
             if (stream->remoteFillLevel != 0){
                 stream->closeStreamInitiated = 1;
                 event->header.flags.bitField.block = 1;
@@ -344,11 +551,18 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
             streamDesc_t *stream = getStreamById(event->deviceHandle.xLinkFD,
                                                  event->header.streamId);
             ASSERT_XLINK(stream);
+            // a coalesced release acknowledges several packets and is not answered
+            uint32_t releasedPackets = event->header.flags.bitField.releaseCount;
+            if (releasedPackets) {
+                event->header.flags.bitField.localServe = 1;
+            } else {
+                releasedPackets = 1;
+            }
             stream->remoteFillLevel -= event->header.size;
-            stream->remoteFillPacketLevel--;
+            stream->remoteFillPacketLevel -= releasedPackets;
 
-            mvLog(MVLOG_DEBUG,"S%d: Got remote release of %ld, remote fill level %ld out of %ld %ld\n",
-                  event->header.streamId, event->header.size, stream->remoteFillLevel, stream->writeSize, stream->readSize);
+            mvLog(MVLOG_DEBUG,"S%d: Got remote release of %ld (%u packets), remote fill level %ld out of %ld %ld\n",
+                  event->header.streamId, event->header.size, releasedPackets, stream->remoteFillLevel, stream->writeSize, stream->readSize);
             releaseStream(stream);
 
             DispatcherUnblockEvent(-1, XLINK_WRITE_REQ, event->header.streamId,
@@ -406,6 +620,10 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
                 XLINK_EVENT_ACKNOWLEDGE(response);
                 mvLog(MVLOG_DEBUG,"%s() got a close stream on aready closed stream\n", __func__);
             } else {
+                if (stream->releaseCreditPackets) {
+                    // the remote has to learn about every release before the stream goes away
+                    flushReleaseCredits(&event->deviceHandle, stream);
+                }
                 if (stream->localFillLevel == 0)
                 {
                     XLINK_EVENT_ACKNOWLEDGE(response);
@@ -414,6 +632,7 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
                     {
                         stream->readSize = 0;
                         stream->closeStreamInitiated = 0;
+                        XLinkStreamDrainPool(stream);
                     }
 
                     if (!stream->writeSize) {
@@ -437,11 +656,22 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
             break;
         }
         case XLINK_PING_REQ:
+        {
             response->header.type = XLINK_PING_RESP;
             XLINK_EVENT_ACKNOWLEDGE(response);
             response->deviceHandle = event->deviceHandle;
+            xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+            if (link && event->header.flags.bitField.handshake) {
+                XLinkHandshakeRead(link, &event->header);
+                XLinkHandshakeWrite(link, &response->header);
+            }
+            if (link && (link->peer.features & XLINK_FEATURE_COMPACT_HEADER)) {
+                // the remote switches once it reads the response, the response itself may go out split
+                XLink_atomic_store(&link->compactHeaderTx, 1);
+            }
             sem_post(&pingSem);
             break;
+        }
         case XLINK_RESET_REQ:
             mvLog(MVLOG_DEBUG,"reset request - received! Sending ACK *****\n");
             XLINK_EVENT_ACKNOWLEDGE(response);
@@ -450,7 +680,16 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
             // need to send the response, serve the event and then reset
             break;
         case XLINK_WRITE_RESP:
+        {
+            if (!event->header.flags.bitField.ack) {
+                streamDesc_t* stream = peekStreamById(event->deviceHandle.xLinkFD,
+                                                      event->header.streamId);
+                if (stream) {
+                    XLink_atomic_fetch_add_64(&stream->stats.nacks, 1);
+                }
+            }
             break;
+        }
         case XLINK_READ_RESP:
             break;
         case XLINK_READ_REL_RESP:
@@ -494,7 +733,16 @@ int dispatcherRemoteEventGetResponse(xLinkEvent_t* event, xLinkEvent_t* response
             break;
         }
         case XLINK_PING_RESP:
+        {
+            xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+            if (link) {
+                XLinkHandshakeRead(link, &event->header);
+            }
+            if (link && (link->peer.features & XLINK_FEATURE_COMPACT_HEADER)) {
+                XLink_atomic_store(&link->compactHeaderTx, 1);
+            }
             break;
+        }
         case XLINK_RESET_RESP:
             break;
         default:
@@ -516,6 +764,7 @@ void dispatcherCloseLink(void* fd, int fullClose)
         mvLog(MVLOG_WARN, "Dispatcher link is null");
         return;
     }
+    XLINK_PROBE2(link_down, link->id, fd);
 
     // TODO investigate race condition that is (probably) later caught
     // due to changing the global `xLinkDesc_t availableXLinks[MAX_LINKS]`
@@ -531,7 +780,11 @@ void dispatcherCloseLink(void* fd, int fullClose)
         return;
     }
 
-    link->id = INVALID_LINK_ID;
+    free(link->sendBatch);
+    link->sendBatch = NULL;
+    free(link->recvBuffer);
+    link->recvBuffer = NULL;
+
     link->deviceHandle.xLinkFD = NULL;
     link->peerState = XLINK_NOT_INIT;
     link->nextUniqueStreamId = 0;
@@ -554,6 +807,9 @@ void dispatcherCloseLink(void* fd, int fullClose)
     if(XLink_sem_destroy(&link->dispatcherClosedSem)) {
         mvLog(MVLOG_DEBUG, "Cannot destroy dispatcherClosedSem\n");
     }
+
+    // Free the slot last, a link connecting meanwhile may take it right away
+    link->id = INVALID_LINK_ID;
 }
 
 void dispatcherCloseDeviceFd(xLinkDeviceHandle_t* deviceHandle)
@@ -561,6 +817,47 @@ void dispatcherCloseDeviceFd(xLinkDeviceHandle_t* deviceHandle)
     XLinkPlatformCloseRemote(deviceHandle);
 }
 
+unsigned int dispatcherFlushDeferred(xLinkDeviceHandle_t* deviceHandle)
+{
+    unsigned int dueMs = XLINK_NO_RW_TIMEOUT;
+    xLinkDesc_t* link = getLink(deviceHandle->xLinkFD);
+    if (link == NULL) {
+        return dueMs;
+    }
+
+    uint64_t nowMs = getMonotonicTimestampMs();
+    for (int index = 0; index < XLINK_MAX_STREAMS; index++) {
+        // credits only change on the dispatcher thread, peek before locking the stream
+        streamId_t id = link->availableStreams[index].id;
+        if (id == INVALID_STREAM_ID || link->availableStreams[index].releaseCreditPackets == 0) {
+            continue;
+        }
+        streamDesc_t* stream = getStreamById(deviceHandle->xLinkFD, id);
+        if (stream == NULL) {
+            continue;
+        }
+        uint64_t elapsedMs = nowMs - stream->releaseCreditSinceMs;
+        if (stream->releaseCreditPackets &&
+            elapsedMs < link->releaseCoalesceDelayMs && isReleaseCoalescing(link)) {
+            unsigned int leftMs = (unsigned int)(link->releaseCoalesceDelayMs - elapsedMs);
+            dueMs = leftMs < dueMs ? leftMs : dueMs;
+        } else if (stream->releaseCreditPackets) {
+            flushReleaseCredits(deviceHandle, stream);
+        }
+        releaseStream(stream);
+    }
+    return dueMs;
+}
+
+int dispatcherFlushSends(xLinkDeviceHandle_t* deviceHandle)
+{
+    xLinkDesc_t* link = getLink(deviceHandle->xLinkFD);
+    if (link == NULL || link->sendBatch == NULL) {
+        return 0;
+    }
+    return flushSendBatch(link->sendBatch, deviceHandle);
+}
+
 // ------------------------------------
 // XLinkDispatcherImpl.h implementation. End.
 // ------------------------------------
@@ -573,7 +870,7 @@ void dispatcherCloseDeviceFd(xLinkDeviceHandle_t* deviceHandle)
 
 int isStreamSpaceEnoughFor(streamDesc_t* stream, uint32_t size)
 {
-    if(stream->remoteFillPacketLevel >= XLINK_MAX_PACKETS_PER_STREAM ||
+    if(stream->remoteFillPacketLevel >= stream->remotePacketCapacity ||
        stream->remoteFillLevel + size > stream->writeSize){
         mvLog(MVLOG_DEBUG, "S%d: Not enough space in stream '%s' for %ld: PKT %ld, FILL %ld SIZE %ld\n",
               stream->id, stream->name, size, stream->remoteFillPacketLevel, stream->remoteFillLevel, stream->writeSize);
@@ -591,7 +888,7 @@ streamPacketDesc_t* getPacketFromStream(streamDesc_t* stream)
         ret = &stream->packets[stream->firstPacketUnused];
         stream->availablePackets--;
         CIRCULAR_INCREMENT(stream->firstPacketUnused,
-                           XLINK_MAX_PACKETS_PER_STREAM);
+                           stream->packetCapacity);
         stream->blockedPackets++;
     }
     return ret;
@@ -616,13 +913,26 @@ streamPacketDesc_t* movePacketFromStream(streamDesc_t* stream)
         // copy fields of first unused packet
         *ret = stream->packets[stream->firstPacketUnused];
 
+        // caller owned buffers can't change hands, hand out a copy instead
+        if (getReadBufferIndex(stream, ret->data) >= 0) {
+            void* copy = XLinkPlatformAllocateData(ALIGN_UP(ret->length, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
+            if (!copy) {
+                mvLog(MVLOG_FATAL, "out of memory to move packet from stream\n");
+                free(ret);
+                return NULL;
+            }
+            memcpy(copy, ret->data, ret->length);
+            deallocatePacketData(stream, ret->data, ret->length);
+            ret->data = copy;
+        }
+
         // mark packet to no longer own data; keep length for later ack's
         stream->packets[stream->firstPacketUnused].data = NULL;
 
         // update circular buffer indices
         stream->availablePackets--;
         CIRCULAR_INCREMENT(stream->firstPacketUnused,
-                           XLINK_MAX_PACKETS_PER_STREAM);
+                           stream->packetCapacity);
         stream->blockedPackets++;
     }
     return ret;
@@ -640,10 +950,9 @@ int releasePacketFromStream(streamDesc_t* stream, uint32_t* releasedSize)
     mvLog(MVLOG_DEBUG, "S%d: Got release of %ld , current local fill level is %ld out of %ld %ld\n",
           stream->id, currPack->length, stream->localFillLevel, stream->readSize, stream->writeSize);
 
-    XLinkPlatformDeallocateData(currPack->data,
-                                ALIGN_UP_INT32((int32_t) currPack->length, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
+    deallocatePacketData(stream, currPack->data, currPack->length);
 
-    CIRCULAR_INCREMENT(stream->firstPacket, XLINK_MAX_PACKETS_PER_STREAM);
+    CIRCULAR_INCREMENT(stream->firstPacket, stream->packetCapacity);
     stream->blockedPackets--;
     if (releasedSize) {
         *releasedSize = currPack->length;
@@ -664,7 +973,7 @@ int releaseSpecificPacketFromStream(streamDesc_t* stream, uint32_t* releasedSize
             found = 1;
             break;
         }
-        CIRCULAR_INCREMENT(packetId, XLINK_MAX_PACKETS_PER_STREAM);
+        CIRCULAR_INCREMENT(packetId, stream->packetCapacity);
     } while (packetId != stream->firstPacketUnused);
     ASSERT_XLINK(found);
 
@@ -677,8 +986,7 @@ int releaseSpecificPacketFromStream(streamDesc_t* stream, uint32_t* releasedSize
 
   mvLog(MVLOG_DEBUG, "S%d: Got release of %ld , current local fill level is %ld out of %ld %ld\n",
           stream->id, currPack->length, stream->localFillLevel, stream->readSize, stream->writeSize);
-    XLinkPlatformDeallocateData(currPack->data,
-                                ALIGN_UP_INT32((int32_t) currPack->length, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
+    deallocatePacketData(stream, currPack->data, currPack->length);
     stream->blockedPackets--;
     if (releasedSize) {
         *releasedSize = currPack->length;
@@ -687,37 +995,221 @@ int releaseSpecificPacketFromStream(streamDesc_t* stream, uint32_t* releasedSize
     if (packetId != stream->firstPacket) {
         uint32_t currIndex = packetId;
         uint32_t nextIndex = currIndex;
-        CIRCULAR_INCREMENT(nextIndex, XLINK_MAX_PACKETS_PER_STREAM);
+        CIRCULAR_INCREMENT(nextIndex, stream->packetCapacity);
         while (currIndex != stream->firstPacketFree) {
             stream->packets[currIndex] = stream->packets[nextIndex];
             currIndex = nextIndex;
-            CIRCULAR_INCREMENT(nextIndex, XLINK_MAX_PACKETS_PER_STREAM);
+            CIRCULAR_INCREMENT(nextIndex, stream->packetCapacity);
         }
-        CIRCULAR_DECREMENT(stream->firstPacketUnused, (XLINK_MAX_PACKETS_PER_STREAM - 1));
-        CIRCULAR_DECREMENT(stream->firstPacketFree, (XLINK_MAX_PACKETS_PER_STREAM - 1));
+        CIRCULAR_DECREMENT(stream->firstPacketUnused, (stream->packetCapacity - 1));
+        CIRCULAR_DECREMENT(stream->firstPacketFree, (stream->packetCapacity - 1));
 
     } else {
-        CIRCULAR_INCREMENT(stream->firstPacket, XLINK_MAX_PACKETS_PER_STREAM);
+        CIRCULAR_INCREMENT(stream->firstPacket, stream->packetCapacity);
     }
 
     return 0;
 }
 
 int addNewPacketToStream(streamDesc_t* stream, void* buffer, uint32_t size, XLinkTimespec trsend, XLinkTimespec treceive) {
-    if (stream->availablePackets + stream->blockedPackets < XLINK_MAX_PACKETS_PER_STREAM)
+    if (stream->availablePackets + stream->blockedPackets < stream->packetCapacity)
     {
         stream->packets[stream->firstPacketFree].data = buffer;
         stream->packets[stream->firstPacketFree].length = size;
         stream->packets[stream->firstPacketFree].tRemoteSent = trsend;
         stream->packets[stream->firstPacketFree].tReceived = treceive;
-        CIRCULAR_INCREMENT(stream->firstPacketFree, XLINK_MAX_PACKETS_PER_STREAM);
+        CIRCULAR_INCREMENT(stream->firstPacketFree, stream->packetCapacity);
         stream->availablePackets++;
         return 0;
     }
     return -1;
 }
 
-int handleIncomingEvent(xLinkEvent_t* event, XLinkTimespec treceive) {
+int isCompactHeaderType(xLinkEventType_t type)
+{
+    switch (type) {
+        case XLINK_WRITE_REQ:
+        case XLINK_WRITE_RESP:
+        case XLINK_READ_REL_REQ:
+        case XLINK_READ_REL_RESP:
+        case XLINK_READ_REL_SPEC_REQ:
+        case XLINK_READ_REL_SPEC_RESP:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int isCompactHeader(const xLinkEventHeader_t* header)
+{
+    uint32_t first;
+    memcpy(&first, header, sizeof(first));
+    return (first & XLINK_COMPACT_HEADER_MARK) != 0;
+}
+
+void packCompactHeader(const xLinkEventHeader_t* header, xLinkCompactEventHeader_t* compactHeader)
+{
+    uint64_t tsec = ((uint64_t)header->tsecMsb << 32) | header->tsecLsb;
+    compactHeader->typeFlags = XLINK_COMPACT_HEADER_MARK |
+                               ((uint32_t)header->type << XLINK_COMPACT_HEADER_TYPE_SHIFT) |
+                               (header->flags.raw & XLINK_COMPACT_HEADER_FLAGS_MASK);
+    compactHeader->id = header->id;
+    compactHeader->streamId = header->streamId;
+    compactHeader->size = header->size;
+    compactHeader->timeNs = tsec * 1000000000ull + header->tnsec;
+}
+
+void unpackCompactHeader(const xLinkCompactEventHeader_t* compactHeader, xLinkEventHeader_t* header)
+{
+    uint64_t tsec = compactHeader->timeNs / 1000000000ull;
+    header->id = compactHeader->id;
+    header->type = (xLinkEventType_t)((compactHeader->typeFlags & ~XLINK_COMPACT_HEADER_MARK) >> XLINK_COMPACT_HEADER_TYPE_SHIFT);
+    header->streamName[0] = '\0';
+    header->tnsec = (uint32_t)(compactHeader->timeNs % 1000000000ull);
+    header->tsecLsb = (uint32_t)tsec;
+    header->tsecMsb = (uint32_t)(tsec >> 32);
+    header->streamId = compactHeader->streamId;
+    header->size = compactHeader->size;
+    header->flags.raw = compactHeader->typeFlags & XLINK_COMPACT_HEADER_FLAGS_MASK;
+}
+
+int setHeaderIoVec(xLinkEventHeader_t* header, int compact,
+                   xLinkCompactEventHeader_t* compactHeader, xLinkPlatformIoVec_t* iov)
+{
+    if (!compact) {
+        iov[0].data = header;
+        iov[0].size = sizeof(*header);
+        return 1;
+    }
+    if (isCompactHeaderType(header->type)) {
+        packCompactHeader(header, compactHeader);
+        iov[0].data = compactHeader;
+        iov[0].size = sizeof(*compactHeader);
+        return 1;
+    }
+    // Message based transports keep the parts apart, as the receiver reads the first one on its own
+    iov[0].data = header;
+    iov[0].size = sizeof(*compactHeader);
+    iov[1].data = (uint8_t*)header + sizeof(*compactHeader);
+    iov[1].size = sizeof(*header) - sizeof(*compactHeader);
+    return 2;
+}
+
+// Bytes of the header, given the first received ones
+uint32_t getHeaderSize(xLinkDesc_t* link, const xLinkEventHeader_t* header, uint32_t received)
+{
+    if (link == NULL || !XLink_atomic_load(&link->compactHeaderRx)) {
+        return sizeof(*header);
+    }
+    if (received < sizeof(xLinkCompactEventHeader_t) || isCompactHeader(header)) {
+        return sizeof(xLinkCompactEventHeader_t);
+    }
+    return sizeof(*header);
+}
+
+int readEventHeader(xLinkDesc_t* link, xLinkEvent_t* event)
+{
+    uint32_t headerSize = getHeaderSize(link, &event->header, 0);
+    int rc = readLinkData(link, &event->deviceHandle, &event->header, headerSize);
+    if (rc < 0 || headerSize == sizeof(event->header)) {
+        return rc;
+    }
+
+    if (isCompactHeader(&event->header)) {
+        xLinkCompactEventHeader_t compactHeader;
+        memcpy(&compactHeader, &event->header, sizeof(compactHeader));
+        unpackCompactHeader(&compactHeader, &event->header);
+        return rc;
+    }
+    return readLinkData(link, &event->deviceHandle, (uint8_t*)&event->header + headerSize,
+                        sizeof(event->header) - headerSize);
+}
+
+int receiveEventPartial(xLinkDesc_t* link, xLinkEvent_t* event, xLinkEventReceiveState_t* state)
+{
+    if(state->headerBytes < sizeof(event->header)) {
+        uint32_t headerSize;
+        while(state->headerBytes < (headerSize = getHeaderSize(link, &event->header, state->headerBytes))) {
+            int rc = readLinkDataNonBlocking(link, &event->deviceHandle,
+                (uint8_t*)&event->header + state->headerBytes, headerSize - state->headerBytes);
+            if(rc < 0) {
+                mvLog(MVLOG_WARN,"%s() Read failed %d\n", __func__, (int)rc);
+                return XLINK_RECEIVE_FAILED;
+            }
+            if(rc == 0) {
+                return XLINK_RECEIVE_INCOMPLETE;
+            }
+            state->headerBytes += rc;
+        }
+        if(headerSize < sizeof(event->header)) {
+            xLinkCompactEventHeader_t compactHeader;
+            memcpy(&compactHeader, &event->header, sizeof(compactHeader));
+            unpackCompactHeader(&compactHeader, &event->header);
+            state->headerBytes = sizeof(event->header);
+        }
+        getMonotonicTimestamp(&state->treceive);
+        noteHeaderFormat(link, &event->header);
+        traceHeaderReceived(event);
+
+        streamDesc_t* stream = NULL;
+        int rc = beginIncomingData(event, &stream, &state->data);
+        state->stream = stream;
+        state->dataBytes = 0;
+        if(rc) {
+            state->headerBytes = 0;
+            return XLINK_RECEIVE_DROPPED;
+        }
+    }
+
+    int readRc = 0;
+    if(state->stream != NULL && state->dataBytes < event->header.size) {
+        readRc = readLinkDataNonBlocking(link, &event->deviceHandle,
+            (uint8_t*)state->data + state->dataBytes, event->header.size - state->dataBytes);
+        if(readRc >= 0) {
+            state->dataBytes += readRc;
+            if(state->dataBytes < event->header.size) {
+                return XLINK_RECEIVE_INCOMPLETE;
+            }
+            readRc = 0;
+        }
+    }
+
+    streamDesc_t* stream = (streamDesc_t*)state->stream;
+    state->headerBytes = 0;
+    state->stream = NULL;
+    if(stream == NULL) {
+        return XLINK_RECEIVE_COMPLETE;
+    }
+    if(completeIncomingData(event, stream, state->data, readRc, state->treceive)) {
+        return readRc < 0 ? XLINK_RECEIVE_FAILED : XLINK_RECEIVE_DROPPED;
+    }
+    return XLINK_RECEIVE_COMPLETE;
+}
+
+// Runs on the reader, before the next header of the link is read
+void noteHeaderFormat(xLinkDesc_t* link, const xLinkEventHeader_t* header)
+{
+    // A ping announcing compact headers is answered announcing them, then the requester sends them.
+    // A response announcing them means the responder sends them already
+    if (link != NULL && (header->type == XLINK_PING_REQ || header->type == XLINK_PING_RESP) &&
+        (XLinkHandshakeFeatures(header) & XLINK_FEATURE_COMPACT_HEADER)) {
+        XLink_atomic_store(&link->compactHeaderRx, 1);
+    }
+}
+
+int handleIncomingEvent(xLinkDesc_t* link, xLinkEvent_t* event, XLinkTimespec treceive) {
+    streamDesc_t* stream = NULL;
+    void* buffer = NULL;
+    int rc = beginIncomingData(event, &stream, &buffer);
+    if(rc || stream == NULL) {
+        return rc;
+    }
+
+    const int sc = readLinkData(link, &event->deviceHandle, buffer, event->header.size);
+    return completeIncomingData(event, stream, buffer, sc, treceive);
+}
+
+int beginIncomingData(xLinkEvent_t* event, streamDesc_t** stream, void** buffer) {
     //this function will be dependent whether this is a client or a Remote
     //specific actions to this peer
     mvLog(MVLOG_DEBUG, "%s, size %u, streamId %u.\n", TypeToStr(event->header.type), event->header.size, event->header.streamId);
@@ -726,25 +1218,39 @@ int handleIncomingEvent(xLinkEvent_t* event, XLinkTimespec treceive) {
                && event->header.type != XLINK_REQUEST_LAST
                && event->header.type < XLINK_RESP_LAST);
 
+    *stream = NULL;
+    *buffer = NULL;
     // Then read the data buffer, which is contained only in the XLINK_WRITE_REQ event
     if(event->header.type != XLINK_WRITE_REQ) {
         return 0;
     }
 
-    int rc = -1;
-    streamDesc_t* stream = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
-    ASSERT_XLINK(stream);
+    streamDesc_t* desc = getStreamById(event->deviceHandle.xLinkFD, event->header.streamId);
+    ASSERT_XLINK(desc);
 
-    stream->localFillLevel += event->header.size;
+    desc->localFillLevel += event->header.size;
     mvLog(MVLOG_DEBUG,"S%u: Got write of %u, current local fill level is %u out of %u %u\n",
-          event->header.streamId, event->header.size, stream->localFillLevel, stream->readSize, stream->writeSize);
+          event->header.streamId, event->header.size, desc->localFillLevel, desc->readSize, desc->writeSize);
 
-    void* buffer = XLinkPlatformAllocateData(ALIGN_UP(event->header.size, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
-    XLINK_OUT_WITH_LOG_IF(buffer == NULL,
-        mvLog(MVLOG_FATAL,"out of memory to receive data of size = %zu\n", event->header.size));
+    void* data = allocatePacketData(desc, &event->deviceHandle, event->header.size);
+    if(data == NULL) {
+        mvLog(MVLOG_FATAL,"out of memory to receive data of size = %zu\n", event->header.size);
+        XLink_atomic_fetch_add_64(&desc->stats.drops, 1);
+        releaseStream(desc);
+        XLINK_EVENT_NOT_ACKNOWLEDGE(event);
+        return -1;
+    }
 
-    const int sc = XLinkPlatformRead(&event->deviceHandle, buffer, event->header.size);
-    XLINK_OUT_WITH_LOG_IF(sc < 0, mvLog(MVLOG_ERROR,"%s() Read failed %d\n", __func__, sc));
+    // the stream stays held while its payload is received
+    *stream = desc;
+    *buffer = data;
+    return 0;
+}
+
+int completeIncomingData(xLinkEvent_t* event, streamDesc_t* stream, void* buffer,
+                         int readRc, XLinkTimespec treceive) {
+    int rc = -1;
+    XLINK_OUT_WITH_LOG_IF(readRc < 0, mvLog(MVLOG_ERROR,"%s() Read failed %d\n", __func__, readRc));
 
     event->data = buffer;
     uint64_t tsec = event->header.tsecLsb | ((uint64_t)event->header.tsecMsb << 32);
@@ -752,20 +1258,301 @@ int handleIncomingEvent(xLinkEvent_t* event, XLinkTimespec treceive) {
         mvLog(MVLOG_WARN,"No more place in stream. release packet\n"));
     rc = 0;
 
+    XLink_atomic_fetch_add_64(&stream->stats.packetsIn, 1);
+    XLink_atomic_fetch_add_64(&stream->stats.bytesIn, event->header.size);
+    XLinkStreamEndBlocked(&stream->stats.readBlockedSinceUs, &stream->stats.blockedReadUs);
+    // only meaningful when both ends share the clock, a remote one ahead is not counted
+    int64_t transitNs = (int64_t)(treceive.tv_sec - tsec) * 1000000000 +
+                        (int64_t)treceive.tv_nsec - (int64_t)event->header.tnsec;
+    if (transitNs >= 0) {
+        XLinkStreamRecordLatency(stream->stats.transitLatency, (uint64_t)transitNs / 1000);
+    }
+
 XLINK_OUT:
+    if(rc != 0) {
+        XLink_atomic_fetch_add_64(&stream->stats.drops, 1);
+        // the buffer goes back to the stream's pool, still under the stream lock
+        deallocatePacketData(stream, buffer, event->header.size);
+        XLINK_EVENT_NOT_ACKNOWLEDGE(event);
+    }
     releaseStream(stream);
 
-    if(rc != 0) {
-        if(buffer != NULL) {
-            XLinkPlatformDeallocateData(buffer,
-                ALIGN_UP(event->header.size, __CACHE_LINE_SIZE), __CACHE_LINE_SIZE);
+    return rc;
+}
+
+int getReadBufferIndex(streamDesc_t* stream, void* data)
+{
+    if (data == NULL) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < stream->readBuffersCount; i++) {
+        if (stream->readBuffers[i] == data) {
+            return (int)i;
         }
-        XLINK_EVENT_NOT_ACKNOWLEDGE(event);
     }
+    return -1;
+}
+
+void* allocatePacketData(streamDesc_t* stream, xLinkDeviceHandle_t* deviceHandle, uint32_t size)
+{
+    void* data = NULL;
+    // Receive straight into a caller registered buffer when one fits
+    if (stream->readBuffersFree && size <= stream->readBufferSize) {
+        for (uint32_t i = 0; i < stream->readBuffersCount; i++) {
+            if (stream->readBuffersFree & (1ULL << i)) {
+                stream->readBuffersFree &= ~(1ULL << i);
+                data = stream->readBuffers[i];
+                break;
+            }
+        }
+    }
+    if (data == NULL) {
+        data = XLinkStreamAllocateData(stream, deviceHandle, size);
+    }
+    XLINK_PROBE3(packet_alloc, stream->id, size, data);
+    return data;
+}
+
+void deallocatePacketData(streamDesc_t* stream, void* data, uint32_t size)
+{
+    XLINK_PROBE3(packet_free, stream->id, size, data);
+    int index = getReadBufferIndex(stream, data);
+    if (index >= 0) {
+        stream->readBuffersFree |= 1ULL << index;
+        return;
+    }
+    XLinkStreamDeallocateData(stream, data, size);
+}
+
+void traceHeaderReceived(xLinkEvent_t* event)
+{
+    xLinkDesc_t* link = getLink(event->deviceHandle.xLinkFD);
+    if (link) {
+        XLinkTraceRecord(&link->trace, XLINK_TRACE_HEADER_RECEIVED, 1, event->header.type,
+                         event->header.id, event->header.streamId, event->header.size);
+    }
+}
+
+int isReleaseCoalescing(xLinkDesc_t* link)
+{
+    // a remote ignoring releaseCount takes a coalesced release for a single one
+    // and the writer's credit drifts, so coalesce only once it announced them
+    return link->releaseCoalescePackets > 1 &&
+           (link->peer.features & XLINK_FEATURE_RELEASE_COALESCING);
+}
+
+void addReleaseCredit(xLinkDesc_t* link, xLinkEvent_t* event,
+                      streamDesc_t* stream, uint32_t packets)
+{
+    if (stream->releaseCreditPackets == 0) {
+        stream->releaseCreditSinceMs = getMonotonicTimestampMs();
+    }
+    stream->releaseCreditPackets += packets;
+    stream->releaseCreditBytes += event->header.size;
+
+    if (stream->releaseCreditPackets >= link->releaseCoalescePackets ||
+        stream->closeStreamInitiated) {
+        flushReleaseCredits(&event->deviceHandle, stream);
+    }
+}
+
+int flushReleaseCredits(xLinkDeviceHandle_t* deviceHandle, streamDesc_t* stream)
+{
+    xLinkEvent_t release = {0};
+    XLINK_INIT_EVENT(release, stream->id, XLINK_READ_REL_REQ,
+        stream->releaseCreditBytes, NULL, *deviceHandle);
+    release.header.flags.bitField.releaseCount = stream->releaseCreditPackets;
+    stream->releaseCreditPackets = 0;
+    stream->releaseCreditBytes = 0;
+
+    int rc = dispatcherEventSend(&release);
+    if (rc) {
+        mvLog(MVLOG_ERROR, "S%d: Failed to send coalesced release (err %d)\n", stream->id, rc);
+    }
+    return rc;
+}
+
+int isTransferBatched(xLinkDesc_t* link, xLinkDeviceHandle_t* deviceHandle)
+{
+    switch (deviceHandle->protocol) {
+        case X_LINK_TCP_IP:
+            return 1;
+        case X_LINK_USB_VSC:
+            // a transfer holds the events the remote wrote with it, once it ends them for us
+            return (link->peer.features & XLINK_FEATURE_BATCHED_EVENTS) != 0;
+        default:
+            // other message based transports keep a transfer per part, which their receivers rely on
+            return 0;
+    }
+}
+
+xLinkSendBatch_t* getSendBatch(xLinkDesc_t* link, xLinkDeviceHandle_t* deviceHandle)
+{
+    if (XLINK_SEND_BATCH_EVENTS < 2 || link == NULL || !isTransferBatched(link, deviceHandle)) {
+        return NULL;
+    }
+    if (link->sendBatch == NULL) {
+        // without one the events are written right away
+        link->sendBatch = (xLinkSendBatch_t*)calloc(1, sizeof(xLinkSendBatch_t));
+    }
+    return link->sendBatch;
+}
+
+int writeEventParts(xLinkSendBatch_t* batch, xLinkDeviceHandle_t* deviceHandle,
+                    const xLinkPlatformIoVec_t* iov, int count)
+{
+    if (batch == NULL) {
+        return count == 1 ? XLinkPlatformWrite(deviceHandle, iov[0].data, iov[0].size)
+                          : XLinkPlatformWritev(deviceHandle, iov, count);
+    }
+
+    uint32_t copySize = 0;
+    int referenced = 0;
+    for (int i = 0; i < count; i++) {
+        if (iov[i].size > XLINK_SEND_BATCH_COPY_SIZE) {
+            referenced = 1;
+        } else {
+            copySize += (uint32_t)iov[i].size;
+        }
+    }
+    if (batch->iovCount + count > XLINK_PLATFORM_MAX_IOV ||
+        batch->stagingBytes + copySize > XLINK_SEND_BATCH_BYTES) {
+        int rc = flushSendBatch(batch, deviceHandle);
+        if (rc < 0) {
+            return rc;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (iov[i].size == 0) {
+            continue;
+        }
+        if (iov[i].size > XLINK_SEND_BATCH_COPY_SIZE) {
+            batch->iov[batch->iovCount++] = iov[i];
+            continue;
+        }
+        uint8_t* staged = &batch->staging[batch->stagingBytes];
+        memcpy(staged, iov[i].data, iov[i].size);
+        batch->stagingBytes += (uint32_t)iov[i].size;
+
+        // consecutive copies are written as one part
+        xLinkPlatformIoVec_t* last = batch->iovCount ? &batch->iov[batch->iovCount - 1] : NULL;
+        if (last && (uint8_t*)last->data + last->size == staged) {
+            last->size += iov[i].size;
+        } else {
+            batch->iov[batch->iovCount].data = staged;
+            batch->iov[batch->iovCount].size = iov[i].size;
+            batch->iovCount++;
+        }
+    }
+    batch->events++;
+
+    // A referenced payload isn't held past the call, its owner may reuse it once the write completes
+    if (referenced || batch->events >= XLINK_SEND_BATCH_EVENTS) {
+        return flushSendBatch(batch, deviceHandle);
+    }
+    return 0;
+}
+
+int flushSendBatch(xLinkSendBatch_t* batch, xLinkDeviceHandle_t* deviceHandle)
+{
+    if (batch->iovCount == 0) {
+        batch->events = 0;
+        return 0;
+    }
+    int rc = XLinkPlatformWriteTransfers(deviceHandle, batch->iov, batch->iovCount);
+    if (rc < 0) {
+        mvLog(MVLOG_ERROR, "Write failed (%u batched events) (err %d)\n", batch->events, rc);
+    }
+    batch->iovCount = 0;
+    batch->events = 0;
+    batch->stagingBytes = 0;
+    return rc < 0 ? rc : 0;
+}
+
+xLinkRecvBuffer_t* getRecvBuffer(xLinkDesc_t* link, xLinkDeviceHandle_t* deviceHandle)
+{
+    if (link == NULL || !isTransferBatched(link, deviceHandle)) {
+        return NULL;
+    }
+    if (link->recvBuffer == NULL) {
+        // without one each read takes what the event needs
+        link->recvBuffer = (xLinkRecvBuffer_t*)calloc(1, sizeof(xLinkRecvBuffer_t));
+    }
+    return link->recvBuffer;
+}
+
+int readLinkData(xLinkDesc_t* link, xLinkDeviceHandle_t* deviceHandle, void* data, uint32_t size)
+{
+    xLinkRecvBuffer_t* buffer = getRecvBuffer(link, deviceHandle);
+    if (buffer == NULL) {
+        return XLinkPlatformRead(deviceHandle, data, size);
+    }
+
+    uint32_t taken = takeRecvBuffer(buffer, data, size);
+    uint32_t left = size - taken;
+    if (left == 0) {
+        return 0;
+    }
+    if (left >= XLINK_RECV_DIRECT_SIZE) {
+        return XLinkPlatformRead(deviceHandle, (uint8_t*)data + taken, left);
+    }
+
+    // The buffer is empty. What arrives along usually holds the next events
+    int rc = XLinkPlatformReadAtLeast(deviceHandle, buffer->data, left, XLINK_RECV_BUFFER_BYTES);
+    if (rc < 0) {
+        return rc;
+    }
+    buffer->start = 0;
+    buffer->end = (uint32_t)rc;
+    takeRecvBuffer(buffer, (uint8_t*)data + taken, left);
+    return 0;
+}
 
+int readLinkDataNonBlocking(xLinkDesc_t* link, xLinkDeviceHandle_t* deviceHandle, void* data, uint32_t size)
+{
+    xLinkRecvBuffer_t* buffer = getRecvBuffer(link, deviceHandle);
+    if (buffer == NULL) {
+        return XLinkPlatformReadNonBlocking(deviceHandle, data, size);
+    }
+
+    if (buffer->start == buffer->end) {
+        if (size >= XLINK_RECV_DIRECT_SIZE) {
+            return XLinkPlatformReadNonBlocking(deviceHandle, data, size);
+        }
+        int rc = fillRecvBuffer(buffer, deviceHandle);
+        if (rc <= 0) {
+            return rc;
+        }
+    }
+    return (int)takeRecvBuffer(buffer, data, size);
+}
+
+int fillRecvBuffer(xLinkRecvBuffer_t* buffer, xLinkDeviceHandle_t* deviceHandle)
+{
+    if (buffer->start == buffer->end) {
+        buffer->start = 0;
+        buffer->end = 0;
+    }
+    int rc = XLinkPlatformReadNonBlocking(deviceHandle, &buffer->data[buffer->end],
+                                          XLINK_RECV_BUFFER_BYTES - buffer->end);
+    if (rc > 0) {
+        buffer->end += (uint32_t)rc;
+    }
     return rc;
 }
 
+uint32_t takeRecvBuffer(xLinkRecvBuffer_t* buffer, void* data, uint32_t size)
+{
+    uint32_t available = buffer->end - buffer->start;
+    uint32_t taken = size < available ? size : available;
+    if (taken) {
+        memcpy(data, &buffer->data[buffer->start], taken);
+        buffer->start += taken;
+    }
+    return taken;
+}
+
 // ------------------------------------
 // Helpers implementation. Begin.
 // ------------------------------------
@@ -20,16 +20,19 @@
  * Will set log level to warnings and above
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // fix for warning: implicit declaration of function 'pthread_setname_np'
+#endif
+
 #include "XLinkLog.h"
 
 
 #include <stdio.h>
 #include <stdarg.h>
 #include <inttypes.h>
-
-#ifndef _GNU_SOURCE
-#define _GNU_SOURCE
-#endif
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 
 #if (defined (WINNT) || defined(_WIN32) || defined(_WIN64) )
 #include "win_pthread.h"
@@ -58,6 +61,12 @@ extern int pthread_getname_np (pthread_t , char *, size_t);
 #include <android/log.h>
 #endif
 
+#if !defined(__DEVICE__) && !defined(__ANDROID__)
+#define MVLOG_ASYNC_SUPPORTED
+#include "XLinkAtomic.h"
+#include "XLinkSemaphore.h"
+#endif
+
 
 #define MVLOG_STR(x) _MVLOG_STR(x)
 #define _MVLOG_STR(x)  #x
@@ -106,6 +115,42 @@ static const char mvLogHeader[MVLOG_LAST][30] =
         MVLOG_FATAL_COLOR "F:"
     };
 
+static const char headerFormat[] = "%s [%s] [%10" PRId64 "] [%s] %s:%d\t";
+
+#ifdef MVLOG_ASYNC_SUPPORTED
+
+#define MVLOG_ASYNC_RING_MASK (MVLOG_ASYNC_RING_SIZE - 1)
+
+typedef struct {
+    volatile uint32_t sequence; // position it is free for, that plus one once written
+    mvLog_t lvl;
+    int line;
+    const char* func;
+    uint64_t timestamp;
+    char threadName[MVLOG_MAXIMUM_THREAD_NAME_SIZE];
+    char message[MVLOG_ASYNC_MESSAGE_SIZE];
+} mvLogAsyncSlot_t;
+
+static mvLogAsyncSlot_t asyncRing[MVLOG_ASYNC_RING_SIZE];
+static volatile uint32_t asyncEnqueuePosition;
+static uint32_t asyncDequeuePosition; // log thread, or the disabling caller once it stopped
+static volatile uint32_t asyncDropped;
+static volatile uint32_t asyncEnabled;
+static volatile uint32_t asyncStopping;
+static int asyncInitialized; // ring and semaphore live on once set up
+static pthread_mutex_t asyncMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t asyncThreadId;
+static sem_t asyncSem;
+
+static mvLogAsyncSlot_t* claimAsyncSlot(uint32_t* position);
+static void writeQueuedMessages(void);
+static void* asyncLogRun(void* ctx);
+static int startAsync(void);
+static void stopAsync(void);
+static void stopAsyncAtExit(void);
+
+#endif // MVLOG_ASYNC_SUPPORTED
+
 
 // Define global and default
 mvLog_t MVLOGLEVEL(global) = MVLOG_LAST;
@@ -134,7 +179,6 @@ logprintf(mvLog_t curLogLvl, mvLog_t lvl, const char * func, const int line,
     if((curLogLvl < MVLOG_LAST && lvl < curLogLvl))
         return 0;
 
-    const char headerFormat[] = "%s [%s] [%10" PRId64 "] [%s] %s:%d\t";
 #ifdef __RTEMS__
     uint64_t timestamp = rtems_clock_get_uptime_nanoseconds() / 1000;
 #elif !defined(_WIN32) && !(defined MA2450 || defined __shave__)
@@ -154,6 +198,27 @@ logprintf(mvLog_t curLogLvl, mvLog_t lvl, const char * func, const int line,
     XLinkLogGetThreadName(threadName, sizeof(threadName));
 #endif
 
+#ifdef MVLOG_ASYNC_SUPPORTED
+    if (XLink_atomic_load(&asyncEnabled)) {
+        uint32_t position = 0;
+        mvLogAsyncSlot_t* slot = claimAsyncSlot(&position);
+        if (slot == NULL) {
+            XLink_atomic_fetch_add(&asyncDropped, 1);
+        } else {
+            slot->lvl = lvl;
+            slot->line = line;
+            slot->func = func;
+            slot->timestamp = timestamp;
+            memcpy(slot->threadName, threadName, sizeof(slot->threadName));
+            vsnprintf(slot->message, sizeof(slot->message), format, args);
+            XLink_atomic_store(&slot->sequence, position + 1);
+            sem_post(&asyncSem);
+        }
+        va_end (args);
+        return 0;
+    }
+#endif
+
 #ifdef __RTEMS__
     if(!rtems_interrupt_is_in_progress())
     {
@@ -189,3 +254,127 @@ logprintf(mvLog_t curLogLvl, mvLog_t lvl, const char * func, const int line,
     va_end (args);
     return 0;
 }
+
+int mvLogSetAsync(int enable)
+{
+#ifdef MVLOG_ASYNC_SUPPORTED
+    int rc = 0;
+    pthread_mutex_lock(&asyncMutex);
+    if (enable && !XLink_atomic_load(&asyncEnabled)) {
+        rc = startAsync();
+    } else if (!enable && XLink_atomic_load(&asyncEnabled)) {
+        stopAsync();
+    }
+    pthread_mutex_unlock(&asyncMutex);
+    return rc;
+#else
+    return enable ? -1 : 0;
+#endif
+}
+
+#ifdef MVLOG_ASYNC_SUPPORTED
+
+// Bounded multi producer queue, each slot's sequence tells whose turn it is
+static mvLogAsyncSlot_t* claimAsyncSlot(uint32_t* position)
+{
+    uint32_t pos = XLink_atomic_load(&asyncEnqueuePosition);
+    for (;;) {
+        mvLogAsyncSlot_t* slot = &asyncRing[pos & MVLOG_ASYNC_RING_MASK];
+        int32_t diff = (int32_t)(XLink_atomic_load(&slot->sequence) - pos);
+        if (diff == 0) {
+            if (XLink_atomic_compare_exchange(&asyncEnqueuePosition, &pos, pos + 1)) {
+                *position = pos;
+                return slot;
+            }
+        } else if (diff < 0) {
+            return NULL; // the log thread didn't write the slot out yet
+        } else {
+            pos = XLink_atomic_load(&asyncEnqueuePosition);
+        }
+    }
+}
+
+static void writeQueuedMessages(void)
+{
+    for (;;) {
+        mvLogAsyncSlot_t* slot = &asyncRing[asyncDequeuePosition & MVLOG_ASYNC_RING_MASK];
+        if (XLink_atomic_load(&slot->sequence) != asyncDequeuePosition + 1) {
+            break;
+        }
+        fprintf(stdout, headerFormat, mvLogHeader[slot->lvl], UNIT_NAME_STR, slot->timestamp,
+                slot->threadName, slot->func, slot->line);
+        fputs(slot->message, stdout);
+        fprintf(stdout, "%s\n", ANSI_COLOR_RESET);
+        XLink_atomic_store(&slot->sequence, asyncDequeuePosition + MVLOG_ASYNC_RING_SIZE);
+        asyncDequeuePosition++;
+    }
+
+    uint32_t dropped = XLink_atomic_exchange(&asyncDropped, 0);
+    if (dropped) {
+        fprintf(stdout, "%s [%s] %u log messages dropped%s\n",
+                mvLogHeader[MVLOG_WARN], UNIT_NAME_STR, dropped, ANSI_COLOR_RESET);
+    }
+    fflush(stdout);
+}
+
+static void* asyncLogRun(void* ctx)
+{
+    (void)ctx;
+    for (;;) {
+        while (sem_wait(&asyncSem) == -1 && errno == EINTR)
+            continue;
+        writeQueuedMessages();
+        if (XLink_atomic_load(&asyncStopping)) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+// Called with asyncMutex held
+static int startAsync(void)
+{
+    if (!asyncInitialized) {
+        if (sem_init(&asyncSem, 0, 0)) {
+            return -1;
+        }
+        for (uint32_t i = 0; i < MVLOG_ASYNC_RING_SIZE; i++) {
+            asyncRing[i].sequence = i;
+        }
+#if !defined(_WIN32) && !defined(_WIN64)
+        // joining threads from atexit isn't safe in a Windows DLL
+        atexit(stopAsyncAtExit);
+#endif
+        asyncInitialized = 1;
+    }
+
+    XLink_atomic_store(&asyncStopping, 0);
+    if (pthread_create(&asyncThreadId, NULL, asyncLogRun, NULL)) {
+        return -1;
+    }
+#ifndef __APPLE__
+    if (pthread_setname_np(asyncThreadId, "XLinkLogThr") != 0) {
+        perror("Setting name for log thread failed");
+    }
+#endif
+    XLink_atomic_store(&asyncEnabled, 1);
+    return 0;
+}
+
+// Called with asyncMutex held
+static void stopAsync(void)
+{
+    XLink_atomic_store(&asyncEnabled, 0);
+    XLink_atomic_store(&asyncStopping, 1);
+    sem_post(&asyncSem);
+    pthread_join(asyncThreadId, NULL);
+    // messages queued while the thread was stopping
+    writeQueuedMessages();
+}
+
+static void stopAsyncAtExit(void)
+{
+    mvLogSetAsync(0);
+}
+
+#endif // MVLOG_ASYNC_SUPPORTED
@@ -3,6 +3,7 @@
 //
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "XLinkErrorUtils.h"
 #include "XLinkPrivateFields.h"
@@ -17,6 +18,8 @@
 
 #include "XLinkLog.h"
 
+#define XLINK_LOCAL_FEATURES (XLINK_FEATURE_COMPACT_HEADER | XLINK_FEATURE_RELEASE_COALESCING)
+
 // ------------------------------------
 // Helpers declaration. Begin.
 // ------------------------------------
@@ -81,7 +84,12 @@ streamId_t XLinkAddOrUpdateStream(void *fd, const char *name,
         XLINK_OUT_IF(getNextAvailableStreamIndex(link, &idx));
         stream = &link->availableStreams[idx];
 
-        XLINK_OUT_IF(XLinkStreamInitialize(stream, nextStreamId, name));
+        XLINK_OUT_IF(XLinkStreamInitialize(stream, nextStreamId, name, link->packetsPerStream));
+        // a remote without capabilities (version 0) holds the fixed XLINK_MAX_PACKETS_PER_STREAM
+        uint32_t remoteCapacity = link->peer.packetsPerStream ?
+                                  link->peer.packetsPerStream : XLINK_MAX_PACKETS_PER_STREAM;
+        stream->remotePacketCapacity = remoteCapacity < stream->packetCapacity ?
+                                       remoteCapacity : stream->packetCapacity;
     }
 
     if (readSize && !stream->readSize) {
@@ -114,6 +122,51 @@ XLINK_OUT:
     return retStreamId;
 }
 
+void XLinkHandshakeWrite(const xLinkDesc_t* link, xLinkEventHeader_t* header)
+{
+    XLinkCapabilities_t caps;
+    memset(&caps, 0, sizeof(caps));
+    caps.version = XLINK_HANDSHAKE_VERSION;
+    caps.features = XLINK_LOCAL_FEATURES;
+    if (link->deviceHandle.protocol == X_LINK_TCP_IP || link->deviceHandle.protocol == X_LINK_USB_VSC) {
+        // the reader takes whole transfers apart, see XLinkPlatformReadAtLeast
+        caps.features |= XLINK_FEATURE_BATCHED_EVENTS;
+    }
+    caps.eventsPerQueue = link->eventsPerQueue;
+    caps.packetsPerStream = link->packetsPerStream;
+
+    memset(header->streamName, 0, sizeof(header->streamName));
+    memcpy(header->streamName, &caps, sizeof(caps));
+    header->flags.bitField.handshake = 1;
+}
+
+void XLinkHandshakeRead(xLinkDesc_t* link, const xLinkEventHeader_t* header)
+{
+    if (!header->flags.bitField.handshake) {
+        // the remote predates the handshake, it only echoes the ping
+        memset(&link->peer, 0, sizeof(link->peer));
+        return;
+    }
+    memcpy(&link->peer, header->streamName, sizeof(link->peer));
+    mvLog(MVLOG_DEBUG, "Remote handshake version %u, features 0x%x\n",
+          link->peer.version, link->peer.features);
+    if (link->peer.packetsPerStream != link->packetsPerStream) {
+        mvLog(MVLOG_WARN, "Remote queues %u packets per stream, this side %u, writes keep to the smaller\n",
+              link->peer.packetsPerStream, link->packetsPerStream);
+    }
+}
+
+// Features announced by a ping, 0 for a remote predating the handshake
+uint32_t XLinkHandshakeFeatures(const xLinkEventHeader_t* header)
+{
+    if (!header->flags.bitField.handshake) {
+        return 0;
+    }
+    XLinkCapabilities_t caps;
+    memcpy(&caps, header->streamName, sizeof(caps));
+    return caps.features;
+}
+
 // ------------------------------------
 // XLinkPrivateDefines API implementation. End.
 // ------------------------------------
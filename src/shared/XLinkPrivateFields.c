@@ -10,6 +10,7 @@
 #include "XLinkPrivateFields.h"
 #include "XLinkPrivateDefines.h"
 #include "XLinkErrorUtils.h"
+#include "XLinkAtomic.h"
 
 #ifdef MVLOG_UNIT_NAME
 #undef MVLOG_UNIT_NAME
@@ -18,13 +19,45 @@
 
 #include "XLinkLog.h"
 
+#define LINK_FD_HINTS_BITS 7
+#define LINK_FD_HINTS (1 << LINK_FD_HINTS_BITS)
+
+// ------------------------------------
+// Global fields declaration. Begin.
+// ------------------------------------
+
+// Slots links were last found in. A hint is used only once the slot is seen
+// to hold the looked up link, otherwise the lookup falls back to a scan.
+static volatile uint32_t linkIndexById[INVALID_LINK_ID + 1];
+static volatile uint32_t linkIndexByFd[LINK_FD_HINTS];
+
+// ------------------------------------
+// Global fields declaration. End.
+// ------------------------------------
+
+static uint32_t hashFd(void* fd)
+{
+    return (uint32_t)(((uint64_t)(uintptr_t)fd * 0x9E3779B97F4A7C15ULL) >> (64 - LINK_FD_HINTS_BITS));
+}
+
 xLinkDesc_t* getLinkById(linkId_t id)
 {
+    // free slots hold the invalid id
+    if (id == INVALID_LINK_ID) {
+        return NULL;
+    }
+
+    uint32_t hint = XLink_atomic_load(&linkIndexById[id]);
+    if (hint < MAX_LINKS && availableXLinks[hint].id == id) {
+        return &availableXLinks[hint];
+    }
+
     XLINK_RET_ERR_IF(pthread_mutex_lock(&availableXLinksMutex) != 0, NULL);
 
     int i;
     for (i = 0; i < MAX_LINKS; i++) {
         if (availableXLinks[i].id == id) {
+            XLink_atomic_store(&linkIndexById[id], (uint32_t)i);
             XLINK_RET_ERR_IF(pthread_mutex_unlock(&availableXLinksMutex) != 0, NULL);
             return &availableXLinks[i];
         }
@@ -36,12 +69,22 @@ xLinkDesc_t* getLinkById(linkId_t id)
 
 xLinkDesc_t* getLink(void* fd)
 {
+    // several free slots share the NULL handle, those are always scanned for the first one
+    if (fd != NULL) {
+        uint32_t hint = XLink_atomic_load(&linkIndexByFd[hashFd(fd)]);
+        if (hint < MAX_LINKS && availableXLinks[hint].deviceHandle.xLinkFD == fd) {
+            return &availableXLinks[hint];
+        }
+    }
 
     XLINK_RET_ERR_IF(pthread_mutex_lock(&availableXLinksMutex) != 0, NULL);
 
     int i;
     for (i = 0; i < MAX_LINKS; i++) {
         if (availableXLinks[i].deviceHandle.xLinkFD == fd) {
+            if (fd != NULL) {
+                XLink_atomic_store(&linkIndexByFd[hashFd(fd)], (uint32_t)i);
+            }
             XLINK_RET_ERR_IF(pthread_mutex_unlock(&availableXLinksMutex) != 0, NULL);
             return &availableXLinks[i];
         }
@@ -65,20 +108,38 @@ streamId_t getStreamIdByName(xLinkDesc_t* link, const char* name)
 }
 
 streamDesc_t* getStreamById(void* fd, streamId_t id)
+{
+    XLINK_RET_ERR_IF(id == INVALID_STREAM_ID, NULL);
+    streamDesc_t* stream = peekStreamById(fd, id);
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    int rc = 0;
+    while(((rc = XLink_sem_wait(&stream->sem)) == -1) && errno == EINTR)
+        continue;
+    if (rc) {
+        mvLog(MVLOG_ERROR,"can't wait semaphore\n");
+        return NULL;
+    }
+    return stream;
+}
+
+streamDesc_t* peekStreamById(void* fd, streamId_t id)
 {
     XLINK_RET_ERR_IF(id == INVALID_STREAM_ID, NULL);
     xLinkDesc_t* link = getLink(fd);
     XLINK_RET_ERR_IF(link == NULL, NULL);
-    int stream;
-    for (stream = 0; stream < XLINK_MAX_STREAMS; stream++) {
+
+    volatile uint32_t* hint = &link->streamIndexHints[id % XLINK_MAX_STREAMS];
+    uint32_t index = XLink_atomic_load(hint);
+    if (index < XLINK_MAX_STREAMS && link->availableStreams[index].id == id) {
+        return &link->availableStreams[index];
+    }
+
+    for (int stream = 0; stream < XLINK_MAX_STREAMS; stream++) {
         if (link->availableStreams[stream].id == id) {
-            int rc = 0;
-            while(((rc = XLink_sem_wait(&link->availableStreams[stream].sem)) == -1) && errno == EINTR)
-                continue;
-            if (rc) {
-                mvLog(MVLOG_ERROR,"can't wait semaphore\n");
-                return NULL;
-            }
+            XLink_atomic_store(hint, (uint32_t)stream);
             return &link->availableStreams[stream];
         }
     }
@@ -0,0 +1,415 @@
+///
+/// @file
+///
+/// @brief     Shared reader threads serving the incoming data of many links
+///
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // fix for warning: implicit declaration of function 'pthread_setname_np'
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "XLinkReactor.h"
+#include "XLinkAtomic.h"
+#include "XLinkPrivateDefines.h"
+
+#define MVLOG_UNIT_NAME xLink
+#include "XLinkLog.h"
+
+#if defined(__linux__)
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define XLINK_REACTOR_MAX_SOURCES MAX_LINKS
+#define XLINK_REACTOR_EVENTS 64
+// epoll data of the descriptor waking a thread up, to stop or serve ready sources
+#define XLINK_REACTOR_WAKE_KEY UINT64_MAX
+
+// ------------------------------------
+// Data structures declaration. Begin.
+// ------------------------------------
+
+typedef struct {
+    int epollFd;
+    int wakeFd;
+    pthread_t threadId;
+    pthread_mutex_t serveMutex; // held while a source is served
+    volatile uint32_t stopping;
+
+    // Sources to serve without waiting for their descriptor, by epoll data
+    pthread_mutex_t readyMutex;
+    uint64_t ready[XLINK_REACTOR_MAX_SOURCES];
+    volatile uint32_t readyCount;
+} reactorThread_t;
+
+/**
+ * @brief Epoll events carry slot and generation, so events still queued
+ *        for a removed source are told apart from the slot's next user
+ */
+typedef struct {
+    xLinkReactorSource_t* source;
+    volatile uint32_t generation; // 0 while the slot is free
+} reactorSlot_t;
+
+// ------------------------------------
+// Data structures declaration. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// Global fields declaration. Begin.
+// ------------------------------------
+
+static pthread_mutex_t reactorMutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int reactorThreadCount; // configured
+static unsigned int reactorThreadsRunning;
+static unsigned int reactorSourceCount;
+static unsigned int reactorNextThread;
+static uint32_t reactorNextGeneration;
+static reactorThread_t reactorThreads[XLINK_REACTOR_MAX_THREADS];
+static reactorSlot_t reactorSlots[XLINK_REACTOR_MAX_SOURCES];
+
+// ------------------------------------
+// Global fields declaration. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static void* reactorRun(void* ctx);
+static int startThreads(void);
+static void stopThreads(void);
+static int watchSource(xLinkReactorSource_t* source, int op);
+static void serveSource(reactorThread_t* thread, uint64_t key);
+static void addReadySource(reactorThread_t* thread, uint64_t key);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// XLinkReactor.h implementation. Begin.
+// ------------------------------------
+
+int XLinkReactorSetThreads(unsigned int count)
+{
+    if (count > XLINK_REACTOR_MAX_THREADS) {
+        count = XLINK_REACTOR_MAX_THREADS;
+    }
+    pthread_mutex_lock(&reactorMutex);
+    if (reactorSourceCount) {
+        pthread_mutex_unlock(&reactorMutex);
+        mvLog(MVLOG_ERROR, "Reader threads can't change while links use them");
+        return -1;
+    }
+    reactorThreadCount = count;
+    pthread_mutex_unlock(&reactorMutex);
+    return 0;
+}
+
+unsigned int XLinkReactorGetThreads(void)
+{
+    return reactorThreadCount;
+}
+
+int XLinkReactorAdd(xLinkReactorSource_t* source)
+{
+    if (source->fd < 0 || source->onReadable == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&reactorMutex);
+    if (reactorThreadCount == 0 ||
+        (reactorThreadsRunning == 0 && startThreads())) {
+        pthread_mutex_unlock(&reactorMutex);
+        return -1;
+    }
+
+    int slot = -1;
+    for (int i = 0; i < XLINK_REACTOR_MAX_SOURCES; i++) {
+        if (reactorSlots[i].generation == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        pthread_mutex_unlock(&reactorMutex);
+        return -1;
+    }
+
+    if (++reactorNextGeneration == 0) {
+        reactorNextGeneration = 1;
+    }
+    source->slot = slot;
+    source->generation = reactorNextGeneration;
+    source->thread = (int)(reactorNextThread++ % reactorThreadsRunning);
+    reactorSlots[slot].source = source;
+    XLink_atomic_store(&reactorSlots[slot].generation, source->generation);
+
+    if (watchSource(source, EPOLL_CTL_ADD)) {
+        mvLog(MVLOG_ERROR, "Can't watch fd %d (err %d)", source->fd, errno);
+        XLink_atomic_store(&reactorSlots[slot].generation, 0);
+        if (reactorSourceCount == 0) {
+            stopThreads();
+        }
+        pthread_mutex_unlock(&reactorMutex);
+        return -1;
+    }
+    reactorSourceCount++;
+    pthread_mutex_unlock(&reactorMutex);
+    return 0;
+}
+
+void XLinkReactorResume(xLinkReactorSource_t* source)
+{
+    // The source may hold data read ahead, so it's called back rather than just watched.
+    // Watching resumes once the callback returns XLINK_REACTOR_CONTINUE
+    reactorThread_t* thread = &reactorThreads[source->thread];
+    addReadySource(thread, ((uint64_t)source->generation << 32) | (uint32_t)source->slot);
+    uint64_t wake = 1;
+    if (write(thread->wakeFd, &wake, sizeof(wake)) != sizeof(wake)) {
+        mvLog(MVLOG_ERROR, "Can't wake reactor thread (err %d)", errno);
+    }
+}
+
+void XLinkReactorRemove(xLinkReactorSource_t* source)
+{
+    reactorThread_t* thread = &reactorThreads[source->thread];
+
+    pthread_mutex_lock(&reactorMutex);
+    XLink_atomic_store(&reactorSlots[source->slot].generation, 0);
+    epoll_ctl(thread->epollFd, EPOLL_CTL_DEL, source->fd, NULL);
+
+    // Wait out a callback already running, later ones see the slot is gone
+    pthread_mutex_lock(&thread->serveMutex);
+    pthread_mutex_unlock(&thread->serveMutex);
+
+    if (--reactorSourceCount == 0) {
+        stopThreads();
+    }
+    pthread_mutex_unlock(&reactorMutex);
+}
+
+// ------------------------------------
+// XLinkReactor.h implementation. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+static void* reactorRun(void* ctx)
+{
+    reactorThread_t* thread = (reactorThread_t*)ctx;
+    struct epoll_event events[XLINK_REACTOR_EVENTS];
+    uint64_t ready[XLINK_REACTOR_MAX_SOURCES];
+
+    mvLog(MVLOG_INFO, "Reactor thread started");
+
+    for (;;) {
+        // only poll while sources are ready anyway
+        int timeoutMs = XLink_atomic_load(&thread->readyCount) ? 0 : -1;
+        int count = epoll_wait(thread->epollFd, events, XLINK_REACTOR_EVENTS, timeoutMs);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            mvLog(MVLOG_ERROR, "epoll_wait failed (err %d)", errno);
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.u64 == XLINK_REACTOR_WAKE_KEY) {
+                if (XLink_atomic_load(&thread->stopping)) {
+                    mvLog(MVLOG_INFO, "Reactor thread stopped");
+                    return NULL;
+                }
+                uint64_t wake;
+                if (read(thread->wakeFd, &wake, sizeof(wake)) != sizeof(wake)) {
+                    mvLog(MVLOG_ERROR, "Can't reset reactor wakeup (err %d)", errno);
+                }
+                continue;
+            }
+            serveSource(thread, events[i].data.u64);
+        }
+
+        // sources served again add themselves for the next round
+        pthread_mutex_lock(&thread->readyMutex);
+        uint32_t readyCount = thread->readyCount;
+        memcpy(ready, thread->ready, readyCount * sizeof(ready[0]));
+        XLink_atomic_store(&thread->readyCount, 0);
+        pthread_mutex_unlock(&thread->readyMutex);
+        for (uint32_t i = 0; i < readyCount; i++) {
+            serveSource(thread, ready[i]);
+        }
+    }
+    return NULL;
+}
+
+// Called with reactorMutex held
+static int startThreads(void)
+{
+    unsigned int started = 0;
+    for (; started < reactorThreadCount; started++) {
+        reactorThread_t* thread = &reactorThreads[started];
+        thread->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        thread->wakeFd = eventfd(0, EFD_CLOEXEC);
+        struct epoll_event wake;
+        memset(&wake, 0, sizeof(wake));
+        wake.events = EPOLLIN;
+        wake.data.u64 = XLINK_REACTOR_WAKE_KEY;
+        if (thread->epollFd < 0 || thread->wakeFd < 0 ||
+            epoll_ctl(thread->epollFd, EPOLL_CTL_ADD, thread->wakeFd, &wake)) {
+            mvLog(MVLOG_ERROR, "Can't create reactor descriptors (err %d)", errno);
+            break;
+        }
+        if (pthread_mutex_init(&thread->serveMutex, NULL) != 0) {
+            mvLog(MVLOG_ERROR, "pthread_mutex_init error");
+            break;
+        }
+        if (pthread_mutex_init(&thread->readyMutex, NULL) != 0) {
+            mvLog(MVLOG_ERROR, "pthread_mutex_init error");
+            pthread_mutex_destroy(&thread->serveMutex);
+            break;
+        }
+        thread->stopping = 0;
+        thread->readyCount = 0;
+        if (pthread_create(&thread->threadId, NULL, reactorRun, thread)) {
+            mvLog(MVLOG_ERROR, "Thread creation failed");
+            pthread_mutex_destroy(&thread->readyMutex);
+            pthread_mutex_destroy(&thread->serveMutex);
+            break;
+        }
+        char reactorThreadName[MVLOG_MAXIMUM_THREAD_NAME_SIZE];
+        snprintf(reactorThreadName, sizeof(reactorThreadName), "Reactor%.2dThr", (int)started);
+        if (pthread_setname_np(thread->threadId, reactorThreadName) != 0) {
+            perror("Setting name for reactor thread failed");
+        }
+    }
+
+    reactorThreadsRunning = started;
+    if (started < reactorThreadCount) {
+        // descriptors of the thread which failed to start
+        reactorThread_t* thread = &reactorThreads[started];
+        if (thread->epollFd >= 0) {
+            close(thread->epollFd);
+        }
+        if (thread->wakeFd >= 0) {
+            close(thread->wakeFd);
+        }
+        stopThreads();
+        return -1;
+    }
+    return 0;
+}
+
+// Called with reactorMutex held, the threads never take it
+static void stopThreads(void)
+{
+    for (unsigned int i = 0; i < reactorThreadsRunning; i++) {
+        reactorThread_t* thread = &reactorThreads[i];
+        XLink_atomic_store(&thread->stopping, 1);
+        uint64_t wake = 1;
+        if (write(thread->wakeFd, &wake, sizeof(wake)) != sizeof(wake)) {
+            mvLog(MVLOG_ERROR, "Can't wake reactor thread (err %d)", errno);
+        }
+        if (pthread_join(thread->threadId, NULL)) {
+            mvLog(MVLOG_ERROR, "Waiting for thread failed");
+        }
+        pthread_mutex_destroy(&thread->readyMutex);
+        pthread_mutex_destroy(&thread->serveMutex);
+        close(thread->epollFd);
+        close(thread->wakeFd);
+    }
+    reactorThreadsRunning = 0;
+}
+
+// One shot, so a source is served by a single thread at a time and
+// stays unwatched after returning XLINK_REACTOR_PAUSE or XLINK_REACTOR_STOP
+static int watchSource(xLinkReactorSource_t* source, int op)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = ((uint64_t)source->generation << 32) | (uint32_t)source->slot;
+    return epoll_ctl(reactorThreads[source->thread].epollFd, op, source->fd, &event);
+}
+
+// Calls the source back, unless it was removed since the key was taken
+static void serveSource(reactorThread_t* thread, uint64_t key)
+{
+    uint32_t slot = (uint32_t)key;
+    uint32_t generation = (uint32_t)(key >> 32);
+
+    pthread_mutex_lock(&thread->serveMutex);
+    if (XLink_atomic_load(&reactorSlots[slot].generation) == generation) {
+        xLinkReactorSource_t* source = reactorSlots[slot].source;
+        int action = source->onReadable(source);
+        if (XLink_atomic_load(&reactorSlots[slot].generation) == generation) {
+            if (action == XLINK_REACTOR_CONTINUE && watchSource(source, EPOLL_CTL_MOD)) {
+                mvLog(MVLOG_ERROR, "Can't watch fd %d again (err %d)", source->fd, errno);
+            } else if (action == XLINK_REACTOR_AGAIN) {
+                addReadySource(thread, key);
+            }
+        }
+    }
+    pthread_mutex_unlock(&thread->serveMutex);
+}
+
+// A source is unwatched while ready, so it's added at most once
+static void addReadySource(reactorThread_t* thread, uint64_t key)
+{
+    pthread_mutex_lock(&thread->readyMutex);
+    if (thread->readyCount < XLINK_REACTOR_MAX_SOURCES) {
+        thread->ready[thread->readyCount] = key;
+        XLink_atomic_store(&thread->readyCount, thread->readyCount + 1);
+    }
+    pthread_mutex_unlock(&thread->readyMutex);
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
+
+#else
+
+int XLinkReactorSetThreads(unsigned int count)
+{
+    return count ? -1 : 0;
+}
+
+unsigned int XLinkReactorGetThreads(void)
+{
+    return 0;
+}
+
+int XLinkReactorAdd(xLinkReactorSource_t* source)
+{
+    (void)source;
+    return -1;
+}
+
+void XLinkReactorResume(xLinkReactorSource_t* source)
+{
+    (void)source;
+}
+
+void XLinkReactorRemove(xLinkReactorSource_t* source)
+{
+    (void)source;
+}
+
+#endif // __linux__
@@ -2,44 +2,63 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // sem_clockwait
+#endif
+
 #include <errno.h>
+#include <time.h>
 #include "XLinkSemaphore.h"
+#include "XLinkAtomic.h"
 #include "XLinkErrorUtils.h"
 #include "XLinkLog.h"
 
-static pthread_mutex_t ref_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t ref_cond = PTHREAD_COND_INITIALIZER;
+#if defined(__linux__)
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static void waitRefsChange(XLink_sem_t* sem, uint32_t refs);
+static void wakeRefsWaiters(XLink_sem_t* sem);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
 
 int XLink_sem_inc(XLink_sem_t* sem)
 {
-    XLINK_RET_IF_FAIL(pthread_mutex_lock(&ref_mutex));
-    if (sem->refs < 0) {
-        // Semaphore has been already destroyed
-        XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
-        return -1;
-    }
-
-    sem->refs++;
-    XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
+    uint32_t refs = XLink_atomic_load(&sem->refs);
+    do {
+        if (refs == XLINK_SEM_DESTROYED) {
+            // Semaphore has been already destroyed
+            return -1;
+        }
+    } while (!XLink_atomic_compare_exchange(&sem->refs, &refs, refs + 1));
 
     return 0;
 }
 
 int XLink_sem_dec(XLink_sem_t* sem)
 {
-    XLINK_RET_IF_FAIL(pthread_mutex_lock(&ref_mutex));
-    if (sem->refs < 1) {
-        // Can't decrement reference count if there are no waiters
-        // or semaphore has been already destroyed
-        XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
-        return -1;
+    uint32_t refs = XLink_atomic_load(&sem->refs);
+    do {
+        if (refs == XLINK_SEM_DESTROYED || (refs & XLINK_SEM_REFS_MASK) == 0) {
+            // Can't decrement reference count if there are no waiters
+            // or semaphore has been already destroyed
+            return -1;
+        }
+    } while (!XLink_atomic_compare_exchange(&sem->refs, &refs, refs - 1));
+
+    if (refs - 1 == XLINK_SEM_DESTROY_WAITING) {
+        wakeRefsWaiters(sem);
     }
-
-    sem->refs--;
-    int ret = pthread_cond_broadcast(&ref_cond);
-    XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
-
-    return ret;
+    return 0;
 }
 
 
@@ -48,9 +67,7 @@ int XLink_sem_init(XLink_sem_t* sem, int pshared, unsigned int value)
     XLINK_RET_ERR_IF(sem == NULL, -1);
 
     XLINK_RET_IF_FAIL(sem_init(&sem->psem, pshared, value));
-    XLINK_RET_IF_FAIL(pthread_mutex_lock(&ref_mutex));
-    sem->refs = 0;
-    XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
+    XLink_atomic_store(&sem->refs, 0);
 
     return 0;
 }
@@ -59,29 +76,36 @@ int XLink_sem_destroy(XLink_sem_t* sem)
 {
     XLINK_RET_ERR_IF(sem == NULL, -1);
 
-    XLINK_RET_IF_FAIL(pthread_mutex_lock(&ref_mutex));
-    if (sem->refs < 0) {
-        // Semaphore has been already destroyed
-        XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
-        return -1;
-    }
-
-    while(sem->refs > 0) {
-        if (pthread_cond_wait(&ref_cond, &ref_mutex)) {
-            break;
-        };
+    uint32_t refs = XLink_atomic_load(&sem->refs);
+    for (;;) {
+        if (refs == XLINK_SEM_DESTROYED) {
+            // Semaphore has been already destroyed
+            return -1;
+        }
+        if ((refs & XLINK_SEM_REFS_MASK) == 0) {
+            if (XLink_atomic_compare_exchange(&sem->refs, &refs, XLINK_SEM_DESTROYED)) {
+                break;
+            }
+            continue;
+        }
+        // the last XLink_sem_dec wakes us up
+        if (!(refs & XLINK_SEM_DESTROY_WAITING)) {
+            if (!XLink_atomic_compare_exchange(&sem->refs, &refs, refs | XLINK_SEM_DESTROY_WAITING)) {
+                continue;
+            }
+            refs |= XLINK_SEM_DESTROY_WAITING;
+        }
+        waitRefsChange(sem, refs);
+        refs = XLink_atomic_load(&sem->refs);
     }
-    sem->refs = -1;
-    int ret = sem_destroy(&sem->psem);
-    XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
 
-    return ret;
+    return sem_destroy(&sem->psem);
 }
 
 int XLink_sem_post(XLink_sem_t* sem)
 {
     XLINK_RET_ERR_IF(sem == NULL, -1);
-    if (sem->refs < 0) {
+    if (XLink_atomic_load(&sem->refs) == XLINK_SEM_DESTROYED) {
         return -1;
     }
 
@@ -115,6 +139,47 @@ int XLink_sem_timedwait(XLink_sem_t* sem, const struct timespec* abstime)
     return ret;
 }
 
+int XLink_sem_timedwait_ms(XLink_sem_t* sem, unsigned int timeoutMs)
+{
+    XLINK_RET_ERR_IF(sem == NULL, -1);
+
+    XLINK_RET_IF_FAIL(XLink_sem_inc(sem));
+    int ret;
+#if defined(HAVE_SEM_CLOCKWAIT)
+    struct timespec abstime;
+    clock_gettime(CLOCK_MONOTONIC, &abstime);
+    abstime.tv_sec += timeoutMs / 1000;
+    abstime.tv_nsec += (long)(timeoutMs % 1000) * 1000000;
+    if (abstime.tv_nsec >= 1000000000) {
+        abstime.tv_sec++;
+        abstime.tv_nsec -= 1000000000;
+    }
+    while(((ret = sem_clockwait(&sem->psem, CLOCK_MONOTONIC, &abstime)) == -1) && errno == EINTR)
+        continue;
+#elif (defined(_WIN32) || defined(_WIN64)) && !defined(__GNUC__)
+    DWORD rc = WaitForSingleObject(sem->psem->handle, timeoutMs);
+    ret = rc == WAIT_OBJECT_0 ? 0 : -1;
+    errno = rc == WAIT_TIMEOUT ? ETIMEDOUT : EINVAL;
+#else
+    // sem_timedwait is influenced by system clock changes, poll instead
+    while ((ret = sem_trywait(&sem->psem)) != 0 && timeoutMs--) {
+#if (defined(_WIN32) || defined(_WIN64))
+        Sleep(1);
+#else
+        usleep(1000);
+#endif
+    }
+    if (ret) {
+        errno = ETIMEDOUT;
+    }
+#endif
+    int err = errno;
+    XLINK_RET_IF_FAIL(XLink_sem_dec(sem));
+    errno = err;
+
+    return ret;
+}
+
 int XLink_sem_trywait(XLink_sem_t* sem)
 {
     XLINK_RET_ERR_IF(sem == NULL, -1);
@@ -130,19 +195,53 @@ int XLink_sem_set_refs(XLink_sem_t* sem, int refs)
 {
     XLINK_RET_ERR_IF(sem == NULL, -1);
     XLINK_RET_ERR_IF(refs < -1, -1);
+    XLINK_RET_ERR_IF(refs > (int)XLINK_SEM_REFS_MASK, -1);
 
-    XLINK_RET_IF_FAIL(pthread_mutex_lock(&ref_mutex));
-    sem->refs = refs;
-    int ret = pthread_cond_broadcast(&ref_cond);
-    XLINK_RET_IF_FAIL(pthread_mutex_unlock(&ref_mutex));
+    XLink_atomic_store(&sem->refs, refs < 0 ? XLINK_SEM_DESTROYED : (uint32_t)refs);
+    wakeRefsWaiters(sem);
 
-    return ret;
+    return 0;
 }
 
 int XLink_sem_get_refs(XLink_sem_t* sem, int *sval)
 {
     XLINK_RET_ERR_IF(sem == NULL, -1);
 
-    *sval = sem->refs;
+    uint32_t refs = XLink_atomic_load(&sem->refs);
+    *sval = refs == XLINK_SEM_DESTROYED ? -1 : (int)(refs & XLINK_SEM_REFS_MASK);
     return 0;
 }
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+// Returns once refs may have changed
+static void waitRefsChange(XLink_sem_t* sem, uint32_t refs)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, &sem->refs, FUTEX_WAIT_PRIVATE, refs, NULL, NULL, 0);
+#elif (defined(_WIN32) || defined(_WIN64))
+    (void)sem;
+    (void)refs;
+    Sleep(1);
+#else
+    (void)sem;
+    (void)refs;
+    usleep(1000);
+#endif
+}
+
+static void wakeRefsWaiters(XLink_sem_t* sem)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, &sem->refs, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+    // waiters poll
+    (void)sem;
+#endif
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
@@ -2,10 +2,16 @@
 // SPDX-License-Identifier: Apache-2.0
 //
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "XLinkStream.h"
 #include "XLinkErrorUtils.h"
+#include "XLinkMacros.h"
+#include "XLinkPlatform.h"
+#include "XLinkPrivateDefines.h"
+#include "XLinkAtomic.h"
+#include "XLinkTime.h"
 
 #ifdef MVLOG_UNIT_NAME
 #undef MVLOG_UNIT_NAME
@@ -15,15 +21,41 @@
 #include "XLinkLog.h"
 #include "XLinkStringUtils.h"
 
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static uint32_t getPoolCapacity(uint32_t size);
+static uint32_t getLatencyBucket(uint64_t us);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
+
 XLinkError_t XLinkStreamInitialize(
-    streamDesc_t* stream, streamId_t id, const char* name) {
+    streamDesc_t* stream, streamId_t id, const char* name, uint32_t packetCapacity) {
     mvLog(MVLOG_DEBUG, "name: %s, id: %ld\n", name, id);
     ASSERT_XLINK(stream);
+    ASSERT_XLINK(packetCapacity);
 
+    // slot may be reused after a close, which keeps the pool and packets
+    XLinkStreamDrainPool(stream);
+    free(stream->packets);
     memset(stream, 0, sizeof(*stream));
 
+    stream->packets = calloc(packetCapacity, sizeof(streamPacketDesc_t));
+    if (stream->packets == NULL) {
+        mvLog(MVLOG_ERROR, "Cannot allocate %u packets\n", packetCapacity);
+        stream->id = INVALID_STREAM_ID;
+        return X_LINK_OUT_OF_MEMORY;
+    }
+    stream->packetCapacity = packetCapacity;
+
     if (XLink_sem_init(&stream->sem, 0, 0)) {
         mvLog(MVLOG_ERROR, "Cannot initialize semaphore\n");
+        free(stream->packets);
+        stream->packets = NULL;
+        stream->id = INVALID_STREAM_ID;
         return X_LINK_ERROR;
     }
 
@@ -43,8 +75,127 @@ void XLinkStreamReset(streamDesc_t* stream) {
         mvLog(MVLOG_DEBUG, "Cannot destroy semaphore\n");
     }
 
+    XLinkStreamDrainPool(stream);
+    free(stream->packets);
+
     // sets all stream fields, including the packets circular buffer to NULL
     // with no check to see if something is open, packet is "blocked", etc.
     memset(stream, 0, sizeof(*stream));
     stream->id = INVALID_STREAM_ID;
 }
+
+void* XLinkStreamAllocateData(streamDesc_t* stream, xLinkDeviceHandle_t* deviceHandle, uint32_t size) {
+    streamBufferPool_t* pool = &stream->pool;
+    uint32_t capacity = getPoolCapacity(size);
+
+    for (uint32_t i = 0; i < pool->count; i++) {
+        if (pool->capacity[i] == capacity) {
+            void* data = pool->data[i];
+            pool->count--;
+            pool->data[i] = pool->data[pool->count];
+            pool->capacity[i] = pool->capacity[pool->count];
+            pool->bytes -= capacity;
+            pool->hits++;
+            return data;
+        }
+    }
+
+    pool->misses++;
+    return XLinkPlatformAllocateDeviceData(deviceHandle, capacity, __CACHE_LINE_SIZE);
+}
+
+void XLinkStreamDeallocateData(streamDesc_t* stream, void* data, uint32_t size) {
+    if (data == NULL) {
+        return;
+    }
+
+    streamBufferPool_t* pool = &stream->pool;
+    uint32_t capacity = getPoolCapacity(size);
+
+    if (pool->count < XLINK_MAX_PACKETS_PER_STREAM &&
+        pool->bytes + capacity <= getPoolCapacity(stream->readSize)) {
+        pool->data[pool->count] = data;
+        pool->capacity[pool->count] = capacity;
+        pool->count++;
+        pool->bytes += capacity;
+        return;
+    }
+
+    XLinkPlatformDeallocateData(data, capacity, __CACHE_LINE_SIZE);
+}
+
+void XLinkStreamDrainPool(streamDesc_t* stream) {
+    streamBufferPool_t* pool = &stream->pool;
+    for (uint32_t i = 0; i < pool->count; i++) {
+        XLinkPlatformDeallocateData(pool->data[i], pool->capacity[i], __CACHE_LINE_SIZE);
+    }
+    pool->count = 0;
+    pool->bytes = 0;
+}
+
+void XLinkStreamRecordLatency(uint32_t* histogram, uint64_t us) {
+    XLink_atomic_fetch_add(&histogram[getLatencyBucket(us)], 1);
+}
+
+void XLinkStreamEndBlocked(uint64_t* sinceUs, uint64_t* totalUs) {
+    if (*sinceUs == 0) {
+        return;
+    }
+    XLink_atomic_fetch_add_64(totalUs, getMonotonicTimestampUs() - *sinceUs);
+    *sinceUs = 0;
+}
+
+void XLinkStreamGetStats(streamDesc_t* stream, XLinkStreamStats_t* stats) {
+    streamStats_t* counters = &stream->stats;
+    stats->packetsOut = XLink_atomic_load_64(&counters->packetsOut);
+    stats->bytesOut = XLink_atomic_load_64(&counters->bytesOut);
+    stats->packetsIn = XLink_atomic_load_64(&counters->packetsIn);
+    stats->bytesIn = XLink_atomic_load_64(&counters->bytesIn);
+    stats->drops = XLink_atomic_load_64(&counters->drops);
+    stats->nacks = XLink_atomic_load_64(&counters->nacks);
+    stats->localFillLevel = XLink_atomic_load(&stream->localFillLevel);
+    stats->remoteFillLevel = XLink_atomic_load(&stream->remoteFillLevel);
+    stats->blockedWriteUs = XLink_atomic_load_64(&counters->blockedWriteUs);
+    stats->blockedReadUs = XLink_atomic_load_64(&counters->blockedReadUs);
+    for (int i = 0; i < XLINK_STATS_LATENCY_BUCKETS; i++) {
+        stats->callLatency[i] = XLink_atomic_load(&counters->callLatency[i]);
+        stats->transitLatency[i] = XLink_atomic_load(&counters->transitLatency[i]);
+    }
+}
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+// Size classes are a quarter of a power of two apart, wasting at most 25%
+uint32_t getPoolCapacity(uint32_t size) {
+    uint32_t capacity = ALIGN_UP(size, __CACHE_LINE_SIZE);
+    if (capacity <= 4 * __CACHE_LINE_SIZE) {
+        return capacity;
+    }
+
+    uint32_t step = 1;
+    while (step <= capacity / 2) {
+        step <<= 1;
+    }
+    step /= 4;
+    return ALIGN_UP(capacity, step);
+}
+
+// Inverse of XLINK_STATS_BUCKET_LOWER_US, large values go to the last bucket
+uint32_t getLatencyBucket(uint64_t us) {
+    if (us < 4) {
+        return (uint32_t)us;
+    }
+
+    uint32_t msb = 2;
+    while (msb < 63 && (us >> (msb + 1))) {
+        msb++;
+    }
+    uint32_t bucket = (msb - 1) * 4 + (uint32_t)((us >> (msb - 2)) & 3);
+    return bucket < XLINK_STATS_LATENCY_BUCKETS ? bucket : XLINK_STATS_LATENCY_BUCKETS - 1;
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
@@ -7,4 +7,19 @@ void getMonotonicTimestamp(XLinkTimespec* ts) {
     auto epoch = now.time_since_epoch();
     ts->tv_sec = std::chrono::duration_cast<std::chrono::seconds>(epoch).count();
     ts->tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(epoch).count() % 1000000000;
-}
\ No newline at end of file
+}
+
+uint64_t getMonotonicTimestampMs(void) {
+    auto epoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(epoch).count();
+}
+
+uint64_t getMonotonicTimestampUs(void) {
+    auto epoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(epoch).count();
+}
+
+uint64_t getMonotonicTimestampNs(void) {
+    auto epoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(epoch).count();
+}
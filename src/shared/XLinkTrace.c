@@ -0,0 +1,190 @@
+///
+/// @file
+///
+/// @brief     Per link ring of binary trace records following events through the dispatcher
+///
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "XLinkTrace.h"
+#include "XLinkAtomic.h"
+#include "XLinkTime.h"
+#include "XLinkDispatcher.h"
+
+#ifdef MVLOG_UNIT_NAME
+#undef MVLOG_UNIT_NAME
+#define MVLOG_UNIT_NAME xLink
+#endif
+#include "XLinkLog.h"
+
+#define XLINK_TRACE_RING_MASK (XLINK_TRACE_RING_SIZE - 1)
+
+// ------------------------------------
+// Helpers declaration. Begin.
+// ------------------------------------
+
+static uint32_t copyRecords(xLinkTraceRing_t* ring, xLinkTraceRecord_t* out);
+static const xLinkTraceRecord_t* findSendBegin(const xLinkTraceRecord_t* records, uint32_t end);
+static void writeRecord(FILE* file, uint32_t linkId, const xLinkTraceRecord_t* records, uint32_t index);
+
+// ------------------------------------
+// Helpers declaration. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// XLinkTrace.h implementation. Begin.
+// ------------------------------------
+
+void XLinkTraceReset(xLinkTraceRing_t* ring)
+{
+    memset(ring, 0, sizeof(*ring));
+}
+
+void XLinkTraceRecord(xLinkTraceRing_t* ring, xLinkTraceStage_t stage, int remote,
+                      uint32_t type, int32_t eventId, uint32_t streamId, uint32_t size)
+{
+    uint32_t position = XLink_atomic_fetch_add(&ring->head, 1);
+    xLinkTraceRecord_t* record = &ring->records[position & XLINK_TRACE_RING_MASK];
+
+    // readers skip the record until the final ticket is in place
+    XLink_atomic_store(&record->ticket, 0);
+    record->stage = (uint8_t)stage;
+    record->remote = (uint8_t)(remote != 0);
+    record->type = (uint16_t)type;
+    record->eventId = eventId;
+    record->streamId = streamId;
+    record->size = size;
+    record->timeNs = getMonotonicTimestampNs();
+    XLink_atomic_store(&record->ticket, position + 1);
+}
+
+int XLinkTraceWriteChrome(xLinkTraceRing_t* ring, uint32_t linkId, const char* path)
+{
+    xLinkTraceRecord_t* records = (xLinkTraceRecord_t*)malloc(sizeof(xLinkTraceRecord_t) * XLINK_TRACE_RING_SIZE);
+    if (records == NULL) {
+        return -1;
+    }
+    uint32_t count = copyRecords(ring, records);
+
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        mvLog(MVLOG_ERROR, "Can't open trace file %s", path);
+        free(records);
+        return -1;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    fprintf(file, "{\"ph\":\"M\",\"pid\":%u,\"name\":\"process_name\",\"args\":{\"name\":\"XLink link %u\"}},\n",
+            linkId, linkId);
+    fprintf(file, "{\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"name\":\"thread_name\",\"args\":{\"name\":\"events\"}},\n",
+            linkId);
+    fprintf(file, "{\"ph\":\"M\",\"pid\":%u,\"tid\":1,\"name\":\"thread_name\",\"args\":{\"name\":\"link writes\"}}",
+            linkId);
+    for (uint32_t i = 0; i < count; i++) {
+        writeRecord(file, linkId, records, i);
+    }
+    fprintf(file, "\n]}\n");
+
+    int rc = ferror(file) ? -1 : 0;
+    if (fclose(file)) {
+        rc = -1;
+    }
+    free(records);
+    return rc;
+}
+
+// ------------------------------------
+// XLinkTrace.h implementation. End.
+// ------------------------------------
+
+
+
+// ------------------------------------
+// Helpers implementation. Begin.
+// ------------------------------------
+
+// Copies the complete records, oldest first
+static uint32_t copyRecords(xLinkTraceRing_t* ring, xLinkTraceRecord_t* out)
+{
+    uint32_t head = XLink_atomic_load(&ring->head);
+    uint32_t first = head > XLINK_TRACE_RING_SIZE ? head - XLINK_TRACE_RING_SIZE : 0;
+    uint32_t count = 0;
+
+    for (uint32_t position = first; position != head; position++) {
+        xLinkTraceRecord_t* record = &ring->records[position & XLINK_TRACE_RING_MASK];
+        if (XLink_atomic_load(&record->ticket) != position + 1) {
+            continue;
+        }
+        out[count] = *record;
+        // a writer which took the slot meanwhile changed the ticket first
+        if (XLink_atomic_load(&record->ticket) != position + 1) {
+            continue;
+        }
+        count++;
+    }
+    return count;
+}
+
+static const xLinkTraceRecord_t* findSendBegin(const xLinkTraceRecord_t* records, uint32_t end)
+{
+    const xLinkTraceRecord_t* sent = &records[end];
+    for (uint32_t i = end; i-- > 0;) {
+        if (records[i].stage == XLINK_TRACE_SEND_BEGIN &&
+            records[i].eventId == sent->eventId &&
+            records[i].type == sent->type &&
+            records[i].remote == sent->remote) {
+            return &records[i];
+        }
+    }
+    return NULL;
+}
+
+// Event lifetimes are async spans keyed by origin and id, link writes are slices
+static void writeRecord(FILE* file, uint32_t linkId, const xLinkTraceRecord_t* records, uint32_t index)
+{
+    const xLinkTraceRecord_t* record = &records[index];
+    const char* origin = record->remote ? "remote" : "local";
+    const char* name = TypeToStr(record->type);
+    double ts = record->timeNs / 1000.0;
+
+    switch ((xLinkTraceStage_t)record->stage) {
+        case XLINK_TRACE_EVENT_ADDED:
+        case XLINK_TRACE_EVENT_SERVED:
+            fprintf(file, ",\n{\"ph\":\"%s\",\"cat\":\"%s\",\"name\":\"%s\",\"id\":\"0x%x\",\"pid\":%u,\"tid\":0,"
+                          "\"ts\":%.3f,\"args\":{\"stream\":%u,\"size\":%u}}",
+                    record->stage == XLINK_TRACE_EVENT_ADDED ? "b" : "e", origin, name,
+                    (uint32_t)record->eventId, linkId, ts, record->streamId, record->size);
+            break;
+        case XLINK_TRACE_EVENT_PICKED:
+        case XLINK_TRACE_HEADER_RECEIVED:
+            fprintf(file, ",\n{\"ph\":\"n\",\"cat\":\"%s\",\"name\":\"%s\",\"id\":\"0x%x\",\"pid\":%u,\"tid\":0,"
+                          "\"ts\":%.3f,\"args\":{\"type\":\"%s\"}}",
+                    origin, record->stage == XLINK_TRACE_EVENT_PICKED ? "picked" : "header received",
+                    (uint32_t)record->eventId, linkId, ts, name);
+            break;
+        case XLINK_TRACE_SEND_END:
+        {
+            // a write still in progress, or whose start was overwritten, is left out
+            const xLinkTraceRecord_t* begin = findSendBegin(records, index);
+            if (begin == NULL) {
+                break;
+            }
+            fprintf(file, ",\n{\"ph\":\"X\",\"cat\":\"%s\",\"name\":\"%s\",\"pid\":%u,\"tid\":1,"
+                          "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":%d,\"stream\":%u,\"size\":%u}}",
+                    origin, name, linkId, begin->timeNs / 1000.0,
+                    (record->timeNs - begin->timeNs) / 1000.0,
+                    (int)record->eventId, record->streamId, record->size);
+            break;
+        }
+        case XLINK_TRACE_SEND_BEGIN:
+            break;
+    }
+}
+
+// ------------------------------------
+// Helpers implementation. End.
+// ------------------------------------
@@ -0,0 +1,103 @@
+#include "loopback_peer.hpp"
+
+// Loopback test of XLinkWriteDataAsync against an in-process fake device:
+// completions arrive in order once the device accepted the data, writes in flight
+// are limited to half the link's eventsPerQueue, and the callbacks may call into XLink.
+
+namespace {
+
+struct Completions {
+    streamId_t stream = INVALID_STREAM_ID;
+    std::mutex mutex;
+    std::vector<const uint8_t*> buffers;
+    int failed = 0;
+    size_t count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return buffers.size();
+    }
+};
+
+void onWritten(const uint8_t* buffer, int size, XLinkError_t status, void* userData) {
+    Completions* completions = (Completions*)userData;
+    XLinkStreamStats_t stats;
+    XLinkError_t statsRc = XLinkGetStreamStats(completions->stream, &stats);
+    std::lock_guard<std::mutex> lock(completions->mutex);
+    if(status != X_LINK_SUCCESS || size != 64 || statsRc != X_LINK_SUCCESS) completions->failed++;
+    completions->buffers.push_back(buffer);
+}
+
+}  // namespace
+
+int main() {
+    XLinkGlobalHandler_t gHandler = {};
+    LOOPBACK_CHECK(XLinkInitialize(&gHandler) == X_LINK_SUCCESS);
+
+    LoopbackPeer peer;
+    LOOPBACK_CHECK(peer.start());
+    std::string address = peer.address();
+    XLinkHandler_t handler = {};
+    handler.devicePath = &address[0];
+    handler.protocol = X_LINK_TCP_IP;
+    // 4 async writes in flight at most, and 2 packets the device holds unreleased
+    XLinkLinkLimits_t limits = {};
+    limits.packetsPerStream = 2;
+    limits.eventsPerQueue = 8;
+    LOOPBACK_CHECK(XLinkConnectWithLimits(&handler, &limits) == X_LINK_SUCCESS);
+
+    streamId_t stream = XLinkOpenStream(handler.linkId, "async", 1024);
+    LOOPBACK_CHECK(stream != INVALID_STREAM_ID);
+
+    constexpr int NUM_WRITES = 6;
+    uint32_t buffers[NUM_WRITES][16];
+    for(int i = 0; i < NUM_WRITES; i++) {
+        for(auto& word : buffers[i]) word = i;
+    }
+    Completions completions;
+    completions.stream = stream;
+
+    // Without releases from the device, the writes past its 2 packets stay in flight
+    peer.holdReleases(true);
+    for(int i = 0; i < 2; i++) {
+        LOOPBACK_CHECK(XLinkWriteDataAsync(stream, (uint8_t*)buffers[i], 64, onWritten, &completions) == X_LINK_SUCCESS);
+    }
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([&]() { return completions.count() == 2; }));
+    for(int i = 2; i < NUM_WRITES; i++) {
+        LOOPBACK_CHECK(XLinkWriteDataAsync(stream, (uint8_t*)buffers[i], 64, onWritten, &completions) == X_LINK_SUCCESS);
+    }
+    uint32_t extra[16] = {0};
+    LOOPBACK_CHECK(XLinkWriteDataAsync(stream, (uint8_t*)extra, 64, onWritten, &completions) == X_LINK_OUT_OF_MEMORY);
+    LOOPBACK_CHECK(completions.count() == 2);
+    LOOPBACK_CHECK(peer.writes() == 2);
+
+    // Once released, the rest completes in order and the device got the data in order
+    peer.holdReleases(false);
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([&]() { return completions.count() == NUM_WRITES; }));
+    LOOPBACK_CHECK(completions.failed == 0);
+    for(int i = 0; i < NUM_WRITES; i++) {
+        LOOPBACK_CHECK(completions.buffers[i] == (const uint8_t*)buffers[i]);
+        streamPacketDesc_t* packet = nullptr;
+        LOOPBACK_CHECK(XLinkReadData(stream, &packet) == X_LINK_SUCCESS);
+        LOOPBACK_CHECK(packet->length == 64 && ((uint32_t*)packet->data)[0] == (uint32_t)i);
+        LOOPBACK_CHECK(XLinkReleaseData(stream) == X_LINK_SUCCESS);
+    }
+
+    // The limit is free again
+    LOOPBACK_CHECK(XLinkWriteDataAsync(stream, (uint8_t*)extra, 64, onWritten, &completions) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([&]() { return completions.count() == NUM_WRITES + 1; }));
+
+    LOOPBACK_CHECK(completions.failed == 0);
+
+    // A write still waiting for the device when the link goes down reports the failure
+    Completions dropped;
+    dropped.stream = stream;
+    peer.holdReleases(true);
+    for(int i = 0; i < 3; i++) {
+        LOOPBACK_CHECK(XLinkWriteDataAsync(stream, (uint8_t*)buffers[i], 64, onWritten, &dropped) == X_LINK_SUCCESS);
+    }
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([&]() { return dropped.count() == 2; }));
+    XLinkResetRemote(handler.linkId);
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([&]() { return dropped.count() == 3; }));
+    LOOPBACK_CHECK(dropped.failed == 1);
+    printf("loopback_async_write: OK\n");
+    return 0;
+}
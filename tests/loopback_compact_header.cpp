@@ -0,0 +1,68 @@
+#include "loopback_peer.hpp"
+
+// Loopback test of compact headers against an in-process fake device announcing them:
+// writes, echoes and releases go back and forth with 24 byte headers, read by a reader
+// thread of the link and by the shared epoll readers.
+
+namespace {
+
+int testCompact(uint32_t features) {
+    LoopbackPeer::Options options;
+    options.handshake = true;
+    options.caps.version = XLINK_HANDSHAKE_VERSION;
+    options.caps.features = features;
+    options.caps.packetsPerStream = XLINK_MAX_PACKETS_PER_STREAM;
+    options.caps.eventsPerQueue = XLINK_DEFAULT_EVENTS_PER_QUEUE;
+    LoopbackPeer peer(options);
+    LOOPBACK_CHECK(peer.start());
+    std::string address = peer.address();
+    XLinkHandler_t handler = {};
+    handler.devicePath = &address[0];
+    handler.protocol = X_LINK_TCP_IP;
+    LOOPBACK_CHECK(XLinkConnect(&handler) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(peer.hostCaps().features & XLINK_FEATURE_COMPACT_HEADER);
+
+    streamId_t stream = XLinkOpenStream(handler.linkId, "compact", 1024);
+    LOOPBACK_CHECK(stream != INVALID_STREAM_ID);
+
+    constexpr uint32_t NUM_ROUNDTRIPS = 64;
+    for(uint32_t i = 0; i < NUM_ROUNDTRIPS; i++) {
+        uint32_t buffer[16];
+        for(auto& word : buffer) word = i;
+        LOOPBACK_CHECK(XLinkWriteData(stream, (uint8_t*)buffer, sizeof(buffer)) == X_LINK_SUCCESS);
+        streamPacketDesc_t* packet = nullptr;
+        LOOPBACK_CHECK(XLinkReadData(stream, &packet) == X_LINK_SUCCESS);
+        LOOPBACK_CHECK(packet->length == sizeof(buffer) && ((uint32_t*)packet->data)[15] == i);
+        LOOPBACK_CHECK(XLinkReleaseData(stream) == X_LINK_SUCCESS);
+    }
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([&]() { return peer.releasedPackets() == NUM_ROUNDTRIPS; }));
+
+    // the host's writes and releases, and its responses to the device's ones
+    if(features & XLINK_FEATURE_COMPACT_HEADER) {
+        LOOPBACK_CHECK(LoopbackPeer::waitUntil([&]() { return peer.compactHeaders() == 4 * NUM_ROUNDTRIPS; }));
+    } else {
+        LOOPBACK_CHECK(peer.compactHeaders() == 0);
+    }
+
+    LOOPBACK_CHECK(XLinkCloseStream(stream) == X_LINK_SUCCESS);
+    XLinkResetRemote(handler.linkId);
+    return 0;
+}
+
+}  // namespace
+
+int main() {
+    XLinkGlobalHandler_t gHandler = {};
+    LOOPBACK_CHECK(XLinkInitialize(&gHandler) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(sizeof(xLinkCompactEventHeader_t) == 24);
+
+    LOOPBACK_CHECK(testCompact(0) == 0);
+    LOOPBACK_CHECK(testCompact(XLINK_FEATURE_COMPACT_HEADER) == 0);
+
+    LOOPBACK_CHECK(XLinkSetTcpReactorThreads(2) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(testCompact(XLINK_FEATURE_COMPACT_HEADER) == 0);
+    LOOPBACK_CHECK(testCompact(XLINK_FEATURE_COMPACT_HEADER | XLINK_FEATURE_RELEASE_COALESCING) == 0);
+
+    printf("loopback_compact_header: OK\n");
+    return 0;
+}
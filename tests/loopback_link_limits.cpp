@@ -0,0 +1,117 @@
+#include "loopback_peer.hpp"
+
+// Loopback test of XLinkConnectWithLimits against an in-process fake device: the
+// limits the host announces, with their defaults and rounding, and writes keeping
+// to the packets and events the device announced it holds.
+
+namespace {
+
+int connectedCaps(const XLinkLinkLimits_t* limits, XLinkCapabilities_t* caps) {
+    LoopbackPeer peer;
+    LOOPBACK_CHECK(peer.start());
+    std::string address = peer.address();
+    XLinkHandler_t handler = {};
+    handler.devicePath = &address[0];
+    handler.protocol = X_LINK_TCP_IP;
+    LOOPBACK_CHECK(XLinkConnectWithLimits(&handler, limits) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(peer.hostHandshake());
+    *caps = peer.hostCaps();
+    XLinkResetRemote(handler.linkId);
+    return 0;
+}
+
+int testAnnouncedLimits() {
+    XLinkCapabilities_t caps;
+
+    LOOPBACK_CHECK(connectedCaps(nullptr, &caps) == 0);
+    LOOPBACK_CHECK(caps.version == XLINK_HANDSHAKE_VERSION);
+    LOOPBACK_CHECK(caps.packetsPerStream == XLINK_MAX_PACKETS_PER_STREAM);
+    LOOPBACK_CHECK(caps.eventsPerQueue == XLINK_DEFAULT_EVENTS_PER_QUEUE);
+    LOOPBACK_CHECK(caps.features & XLINK_FEATURE_BATCHED_EVENTS);
+
+    XLinkLinkLimits_t limits = {};
+    LOOPBACK_CHECK(connectedCaps(&limits, &caps) == 0);
+    LOOPBACK_CHECK(caps.packetsPerStream == XLINK_MAX_PACKETS_PER_STREAM);
+    LOOPBACK_CHECK(caps.eventsPerQueue == XLINK_DEFAULT_EVENTS_PER_QUEUE);
+
+    // events per queue are rounded up to a power of two between 2 and 65536
+    limits.packetsPerStream = 5;
+    limits.eventsPerQueue = 5;
+    LOOPBACK_CHECK(connectedCaps(&limits, &caps) == 0);
+    LOOPBACK_CHECK(caps.packetsPerStream == 5);
+    LOOPBACK_CHECK(caps.eventsPerQueue == 8);
+
+    limits.eventsPerQueue = 1;
+    LOOPBACK_CHECK(connectedCaps(&limits, &caps) == 0);
+    LOOPBACK_CHECK(caps.eventsPerQueue == 2);
+
+    limits.eventsPerQueue = 100000;
+    LOOPBACK_CHECK(connectedCaps(&limits, &caps) == 0);
+    LOOPBACK_CHECK(caps.eventsPerQueue == 65536);
+    return 0;
+}
+
+void onWritten(const uint8_t*, int, XLinkError_t status, void* userData) {
+    if(status == X_LINK_SUCCESS) ((std::atomic<int>*)userData)->fetch_add(1);
+}
+
+int testRemoteCredit() {
+    // The device holds 2 packets of a stream and 4 events, the host 64 of both
+    LoopbackPeer::Options options;
+    options.handshake = true;
+    options.caps.version = XLINK_HANDSHAKE_VERSION;
+    options.caps.packetsPerStream = 2;
+    options.caps.eventsPerQueue = 4;
+    LoopbackPeer peer(options);
+    LOOPBACK_CHECK(peer.start());
+    std::string address = peer.address();
+    XLinkHandler_t handler = {};
+    handler.devicePath = &address[0];
+    handler.protocol = X_LINK_TCP_IP;
+    LOOPBACK_CHECK(XLinkConnect(&handler) == X_LINK_SUCCESS);
+
+    streamId_t stream = XLinkOpenStream(handler.linkId, "credit", 1024);
+    LOOPBACK_CHECK(stream != INVALID_STREAM_ID);
+
+    peer.holdReleases(true);
+    uint8_t buffer[64] = {0};
+    LOOPBACK_CHECK(XLinkWriteData(stream, buffer, sizeof(buffer)) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(XLinkWriteData(stream, buffer, sizeof(buffer)) == X_LINK_SUCCESS);
+
+    // a third write waits for the device to release one
+    std::atomic<int> written{0};
+    LOOPBACK_CHECK(XLinkWriteDataAsync(stream, buffer, sizeof(buffer), onWritten, &written) == X_LINK_SUCCESS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    LOOPBACK_CHECK(written == 0);
+    LOOPBACK_CHECK(peer.writes() == 2);
+
+    // half the device's events are in flight with a second one
+    LOOPBACK_CHECK(XLinkWriteDataAsync(stream, buffer, sizeof(buffer), onWritten, &written) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(XLinkWriteDataAsync(stream, buffer, sizeof(buffer), onWritten, &written) == X_LINK_OUT_OF_MEMORY);
+
+    peer.holdReleases(false);
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([&]() { return written == 2; }));
+    LOOPBACK_CHECK(peer.writes() == 4);
+
+    for(int i = 0; i < 4; i++) {
+        streamPacketDesc_t* packet = nullptr;
+        LOOPBACK_CHECK(XLinkReadData(stream, &packet) == X_LINK_SUCCESS);
+        LOOPBACK_CHECK(XLinkReleaseData(stream) == X_LINK_SUCCESS);
+    }
+    LOOPBACK_CHECK(XLinkCloseStream(stream) == X_LINK_SUCCESS);
+    XLinkResetRemote(handler.linkId);
+    return 0;
+}
+
+}  // namespace
+
+int main() {
+    XLinkGlobalHandler_t gHandler = {};
+    LOOPBACK_CHECK(XLinkInitialize(&gHandler) == X_LINK_SUCCESS);
+
+    LOOPBACK_CHECK(testAnnouncedLimits() == 0);
+    LOOPBACK_CHECK(testRemoteCredit() == 0);
+
+    printf("loopback_link_limits: OK\n");
+    return 0;
+}
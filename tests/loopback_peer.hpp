@@ -0,0 +1,354 @@
+#pragma once
+
+// In-process fake device for the loopback tests. It answers an XLink host connected
+// over TCP to 127.0.0.1 the way a booted device would: it opens the streams the host
+// opens, answers and releases every write, and echoes the data back on the same stream.
+// Announcing XLINK_FEATURE_COMPACT_HEADER, it sends and reads compact headers once
+// the host announced them too.
+
+#include <XLink/XLink.h>
+#include <XLink/XLinkPrivateDefines.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define LOOPBACK_CHECK(cond) do { \
+    if(!(cond)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        return 1; \
+    } \
+} while(0)
+
+struct LoopbackPeerOptions {
+    bool handshake = false;       // answer the connect ping with caps, otherwise act as a version 0 device
+    XLinkCapabilities_t caps = {}; // features may include XLINK_FEATURE_COMPACT_HEADER
+    bool echo = true;             // send every write back on its stream
+};
+
+class LoopbackPeer {
+public:
+    using Options = LoopbackPeerOptions;
+
+    explicit LoopbackPeer(const Options& options = Options()) : options(options) {}
+
+    ~LoopbackPeer() {
+        if(fd >= 0) shutdown(fd, SHUT_RDWR);
+        if(listenFd >= 0) shutdown(listenFd, SHUT_RDWR);
+        if(thread.joinable()) thread.join();
+        if(fd >= 0) close(fd);
+        if(listenFd >= 0) close(listenFd);
+    }
+
+    // Listens on an ephemeral port and serves the first connection
+    bool start() {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if(listenFd < 0) return false;
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if(bind(listenFd, (sockaddr*)&addr, sizeof(addr)) || listen(listenFd, 1) ||
+           getsockname(listenFd, (sockaddr*)&addr, &len)) {
+            return false;
+        }
+        port = ntohs(addr.sin_port);
+        thread = std::thread([this]() { serve(); });
+        return true;
+    }
+
+    // devicePath for XLinkConnect
+    std::string address() const {
+        return "127.0.0.1:" + std::to_string(port);
+    }
+
+    // While held, writes are still answered but not released, as by a device nobody reads on
+    void holdReleases(bool hold) {
+        std::lock_guard<std::mutex> lock(mutex);
+        held = hold;
+        if(!held) {
+            for(const auto& release : heldReleases) sendLocked(release, nullptr);
+            heldReleases.clear();
+        }
+    }
+
+    bool hostHandshake() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return receivedHandshake;
+    }
+    XLinkCapabilities_t hostCaps() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return receivedCaps;
+    }
+    uint32_t writes() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return writesReceived;
+    }
+    uint32_t releases() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return releasesReceived;
+    }
+    uint32_t releasedPackets() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return packetsReleased;
+    }
+    // Compact headers received from the host
+    uint32_t compactHeaders() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return compactHeadersReceived;
+    }
+
+    template<typename Condition>
+    static bool waitUntil(Condition condition, int timeoutMs = 2000) {
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while(!condition()) {
+            if(std::chrono::steady_clock::now() > end) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+private:
+    struct Echo {
+        uint32_t size;
+        std::vector<uint8_t> data;
+    };
+
+    void serve() {
+        fd = accept(listenFd, nullptr, nullptr);
+        if(fd < 0) return;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        xLinkEventHeader_t header;
+        while(receiveHeader(&header)) {
+            if(!handle(header)) break;
+        }
+    }
+
+    bool receiveHeader(xLinkEventHeader_t* header) {
+        if(!compactRx) return receive(header, sizeof(*header));
+
+        // compact headers are told apart from full ones by their first bytes
+        xLinkCompactEventHeader_t compact;
+        if(!receive(&compact, sizeof(compact))) return false;
+        if(!(compact.typeFlags & XLINK_COMPACT_HEADER_MARK)) {
+            memcpy(header, &compact, sizeof(compact));
+            return receive((uint8_t*)header + sizeof(compact), sizeof(*header) - sizeof(compact));
+        }
+        *header = {};
+        header->id = compact.id;
+        header->type = (xLinkEventType_t)((compact.typeFlags & ~XLINK_COMPACT_HEADER_MARK) >> XLINK_COMPACT_HEADER_TYPE_SHIFT);
+        header->streamId = compact.streamId;
+        header->size = compact.size;
+        header->flags.raw = compact.typeFlags & XLINK_COMPACT_HEADER_FLAGS_MASK;
+        std::lock_guard<std::mutex> lock(mutex);
+        compactHeadersReceived++;
+        return true;
+    }
+
+    bool handle(const xLinkEventHeader_t& request) {
+        xLinkEventHeader_t response = request;
+        response.flags.raw = 0;
+        response.flags.bitField.ack = 1;
+
+        switch(request.type) {
+            case XLINK_PING_REQ: {
+                std::lock_guard<std::mutex> lock(mutex);
+                response.type = XLINK_PING_RESP;
+                memset(response.streamName, 0, sizeof(response.streamName));
+                if(request.flags.bitField.handshake) {
+                    receivedHandshake = true;
+                    memcpy(&receivedCaps, request.streamName, sizeof(receivedCaps));
+                    if(options.handshake) {
+                        memcpy(response.streamName, &options.caps, sizeof(options.caps));
+                        response.flags.bitField.handshake = 1;
+                    }
+                }
+                sendLocked(response, nullptr);
+                // the host sends them once it reads the response, this side from now on
+                if(response.flags.bitField.handshake &&
+                   (options.caps.features & receivedCaps.features & XLINK_FEATURE_COMPACT_HEADER)) {
+                    compactRx = true;
+                    compactTx = true;
+                }
+                return true;
+            }
+            case XLINK_CREATE_STREAM_REQ: {
+                std::lock_guard<std::mutex> lock(mutex);
+                response.type = XLINK_CREATE_STREAM_RESP;
+                sendLocked(response, nullptr);
+                // open it on this side too, so the host takes writes on it
+                xLinkEventHeader_t create = request;
+                create.id = nextId++;
+                create.flags.raw = 0;
+                sendLocked(create, nullptr);
+                return true;
+            }
+            case XLINK_WRITE_REQ: {
+                std::vector<uint8_t> data(request.size);
+                if(request.size && !receive(data.data(), request.size)) return false;
+                std::lock_guard<std::mutex> lock(mutex);
+                writesReceived++;
+                response.type = XLINK_WRITE_RESP;
+                sendLocked(response, nullptr);
+
+                xLinkEventHeader_t release = makeHeader(XLINK_READ_REL_REQ, request.streamId, request.size);
+                if(held) {
+                    heldReleases.push_back(release);
+                } else {
+                    sendLocked(release, nullptr);
+                }
+                if(options.echo) {
+                    echoes[request.streamId].push_back(Echo{request.size, std::move(data)});
+                    drainEchoes(request.streamId);
+                }
+                return true;
+            }
+            case XLINK_READ_REL_REQ: {
+                std::lock_guard<std::mutex> lock(mutex);
+                const uint32_t count = request.flags.bitField.releaseCount;
+                releasesReceived++;
+                packetsReleased += count ? count : 1;
+                unreleased[request.streamId] -= count ? count : 1;
+                if(!count) {
+                    // a coalesced release is not answered
+                    response.type = XLINK_READ_REL_RESP;
+                    sendLocked(response, nullptr);
+                }
+                drainEchoes(request.streamId);
+                return true;
+            }
+            case XLINK_CLOSE_STREAM_REQ: {
+                std::lock_guard<std::mutex> lock(mutex);
+                response.type = XLINK_CLOSE_STREAM_RESP;
+                sendLocked(response, nullptr);
+                return true;
+            }
+            case XLINK_RESET_REQ: {
+                std::lock_guard<std::mutex> lock(mutex);
+                response.type = XLINK_RESET_RESP;
+                sendLocked(response, nullptr);
+                return false;
+            }
+            default:
+                // responses to what this side sent
+                return true;
+        }
+    }
+
+    // Echoes as many packets as the host has room for
+    void drainEchoes(streamId_t streamId) {
+        const uint32_t capacity = receivedCaps.packetsPerStream ? receivedCaps.packetsPerStream
+                                                                : XLINK_MAX_PACKETS_PER_STREAM;
+        auto& queue = echoes[streamId];
+        while(!queue.empty() && unreleased[streamId] < (int)capacity) {
+            Echo& echo = queue.front();
+            sendLocked(makeHeader(XLINK_WRITE_REQ, streamId, echo.size), echo.data.data());
+            unreleased[streamId]++;
+            queue.pop_front();
+        }
+    }
+
+    xLinkEventHeader_t makeHeader(xLinkEventType_t type, streamId_t streamId, uint32_t size) {
+        xLinkEventHeader_t header = {};
+        header.id = nextId++;
+        header.type = type;
+        header.streamId = streamId;
+        header.size = size;
+        // the host measures transit against its monotonic clock
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        uint64_t sec = (uint64_t)(now / 1000000000);
+        header.tsecLsb = (uint32_t)sec;
+        header.tsecMsb = (uint32_t)(sec >> 32);
+        header.tnsec = (uint32_t)(now % 1000000000);
+        return header;
+    }
+
+    void sendLocked(const xLinkEventHeader_t& header, const uint8_t* payload) {
+        if(compactTx && isDataEvent(header.type)) {
+            xLinkCompactEventHeader_t compact = {};
+            compact.typeFlags = XLINK_COMPACT_HEADER_MARK | ((uint32_t)header.type << XLINK_COMPACT_HEADER_TYPE_SHIFT) |
+                                (header.flags.raw & XLINK_COMPACT_HEADER_FLAGS_MASK);
+            compact.id = header.id;
+            compact.streamId = header.streamId;
+            compact.size = header.size;
+            uint64_t sec = ((uint64_t)header.tsecMsb << 32) | header.tsecLsb;
+            compact.timeNs = sec * 1000000000ull + header.tnsec;
+            sendAll(&compact, sizeof(compact));
+        } else {
+            sendAll(&header, sizeof(header));
+        }
+        if(header.type == XLINK_WRITE_REQ && header.size) sendAll(payload, header.size);
+    }
+
+    static bool isDataEvent(xLinkEventType_t type) {
+        switch(type) {
+            case XLINK_WRITE_REQ:
+            case XLINK_WRITE_RESP:
+            case XLINK_READ_REL_REQ:
+            case XLINK_READ_REL_RESP:
+            case XLINK_READ_REL_SPEC_REQ:
+            case XLINK_READ_REL_SPEC_RESP:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void sendAll(const void* data, size_t size) {
+        const char* p = (const char*)data;
+        while(size) {
+            ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+            if(n <= 0) return;
+            p += n;
+            size -= (size_t)n;
+        }
+    }
+
+    bool receive(void* data, size_t size) {
+        char* p = (char*)data;
+        while(size) {
+            ssize_t n = recv(fd, p, size, 0);
+            if(n <= 0) return false;
+            p += n;
+            size -= (size_t)n;
+        }
+        return true;
+    }
+
+    Options options;
+    int listenFd = -1;
+    std::atomic<int> fd{-1};
+    uint16_t port = 0;
+    std::thread thread;
+
+    std::mutex mutex; // serializes sends and guards the state below
+    eventId_t nextId = 0x10000;
+    bool held = false;
+    std::vector<xLinkEventHeader_t> heldReleases;
+    std::map<streamId_t, std::deque<Echo>> echoes;
+    std::map<streamId_t, int> unreleased; // echoed packets the host holds
+    bool receivedHandshake = false;
+    XLinkCapabilities_t receivedCaps = {};
+    uint32_t writesReceived = 0;
+    uint32_t releasesReceived = 0;
+    uint32_t packetsReleased = 0;
+    uint32_t compactHeadersReceived = 0;
+    bool compactRx = false; // used by the serving thread only
+    bool compactTx = false;
+};
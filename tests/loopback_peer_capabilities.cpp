@@ -0,0 +1,94 @@
+#include "loopback_peer.hpp"
+
+// Loopback test of XLinkGetPeerCapabilities against an in-process fake device, both
+// as a version 0 device which doesn't take part in the handshake and as one announcing
+// its capabilities, and of XLinkSetReleaseCoalescing depending on them.
+
+namespace {
+
+int roundtrips(streamId_t stream, int count) {
+    uint8_t buffer[64] = {0};
+    for(int i = 0; i < count; i++) {
+        LOOPBACK_CHECK(XLinkWriteData(stream, buffer, sizeof(buffer)) == X_LINK_SUCCESS);
+        streamPacketDesc_t* packet = nullptr;
+        LOOPBACK_CHECK(XLinkReadData(stream, &packet) == X_LINK_SUCCESS);
+        LOOPBACK_CHECK(XLinkReleaseData(stream) == X_LINK_SUCCESS);
+    }
+    return 0;
+}
+
+int testVersion0() {
+    LoopbackPeer peer;
+    LOOPBACK_CHECK(peer.start());
+    std::string address = peer.address();
+    XLinkHandler_t handler = {};
+    handler.devicePath = &address[0];
+    handler.protocol = X_LINK_TCP_IP;
+    LOOPBACK_CHECK(XLinkConnect(&handler) == X_LINK_SUCCESS);
+
+    XLinkCapabilities_t caps;
+    memset(&caps, 0xff, sizeof(caps));
+    LOOPBACK_CHECK(XLinkGetPeerCapabilities(handler.linkId, &caps) == X_LINK_SUCCESS);
+    XLinkCapabilities_t none = {};
+    LOOPBACK_CHECK(memcmp(&caps, &none, sizeof(caps)) == 0);
+    LOOPBACK_CHECK(XLinkGetPeerCapabilities(handler.linkId, nullptr) != X_LINK_SUCCESS);
+
+    // it can't take coalesced releases, disabling them is fine
+    LOOPBACK_CHECK(XLinkSetReleaseCoalescing(handler.linkId, 8, 1000) != X_LINK_SUCCESS);
+    LOOPBACK_CHECK(XLinkSetReleaseCoalescing(handler.linkId, 0, 0) == X_LINK_SUCCESS);
+
+    streamId_t stream = XLinkOpenStream(handler.linkId, "caps", 1024);
+    LOOPBACK_CHECK(stream != INVALID_STREAM_ID);
+    LOOPBACK_CHECK(roundtrips(stream, 8) == 0);
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([&]() { return peer.releasedPackets() == 8; }));
+    LOOPBACK_CHECK(peer.releases() == 8);
+
+    LOOPBACK_CHECK(XLinkCloseStream(stream) == X_LINK_SUCCESS);
+    XLinkResetRemote(handler.linkId);
+    return 0;
+}
+
+int testAnnounced() {
+    LoopbackPeer::Options options;
+    options.handshake = true;
+    options.caps.version = XLINK_HANDSHAKE_VERSION;
+    options.caps.features = XLINK_FEATURE_RELEASE_COALESCING;
+    options.caps.eventsPerQueue = 32;
+    options.caps.packetsPerStream = XLINK_MAX_PACKETS_PER_STREAM;
+    LoopbackPeer peer(options);
+    LOOPBACK_CHECK(peer.start());
+    std::string address = peer.address();
+    XLinkHandler_t handler = {};
+    handler.devicePath = &address[0];
+    handler.protocol = X_LINK_TCP_IP;
+    LOOPBACK_CHECK(XLinkConnect(&handler) == X_LINK_SUCCESS);
+
+    XLinkCapabilities_t caps;
+    LOOPBACK_CHECK(XLinkGetPeerCapabilities(handler.linkId, &caps) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(memcmp(&caps, &options.caps, sizeof(caps)) == 0);
+
+    // 8 releases leave as one
+    LOOPBACK_CHECK(XLinkSetReleaseCoalescing(handler.linkId, 8, 1000) == X_LINK_SUCCESS);
+    streamId_t stream = XLinkOpenStream(handler.linkId, "caps", 1024);
+    LOOPBACK_CHECK(stream != INVALID_STREAM_ID);
+    LOOPBACK_CHECK(roundtrips(stream, 8) == 0);
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([&]() { return peer.releasedPackets() == 8; }));
+    LOOPBACK_CHECK(peer.releases() == 1);
+
+    LOOPBACK_CHECK(XLinkCloseStream(stream) == X_LINK_SUCCESS);
+    XLinkResetRemote(handler.linkId);
+    return 0;
+}
+
+}  // namespace
+
+int main() {
+    XLinkGlobalHandler_t gHandler = {};
+    LOOPBACK_CHECK(XLinkInitialize(&gHandler) == X_LINK_SUCCESS);
+
+    LOOPBACK_CHECK(testVersion0() == 0);
+    LOOPBACK_CHECK(testAnnounced() == 0);
+
+    printf("loopback_peer_capabilities: OK\n");
+    return 0;
+}
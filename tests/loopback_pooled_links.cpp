@@ -0,0 +1,67 @@
+#include "loopback_peer.hpp"
+
+// Loopback test of links on the shared scheduler workers and epoll readers: several
+// links connect, exchange packets and disconnect over and over, each against its own
+// in-process fake device, after which no link holds on to the shared threads.
+
+namespace {
+
+constexpr int NUM_LINKS = 4;
+constexpr int NUM_ROUNDS = 20;
+constexpr uint32_t NUM_ROUNDTRIPS = 16;
+
+int connectAndDisconnect(int link) {
+    LoopbackPeer peer;
+    LOOPBACK_CHECK(peer.start());
+    std::string address = peer.address();
+    XLinkHandler_t handler = {};
+    handler.devicePath = &address[0];
+    handler.protocol = X_LINK_TCP_IP;
+    LOOPBACK_CHECK(XLinkConnect(&handler) == X_LINK_SUCCESS);
+
+    streamId_t stream = XLinkOpenStream(handler.linkId, "pooled", 1024);
+    LOOPBACK_CHECK(stream != INVALID_STREAM_ID);
+    for(uint32_t i = 0; i < NUM_ROUNDTRIPS; i++) {
+        uint32_t buffer[16];
+        for(auto& word : buffer) word = (uint32_t)link << 16 | i;
+        LOOPBACK_CHECK(XLinkWriteData(stream, (uint8_t*)buffer, sizeof(buffer)) == X_LINK_SUCCESS);
+        streamPacketDesc_t* packet = nullptr;
+        LOOPBACK_CHECK(XLinkReadData(stream, &packet) == X_LINK_SUCCESS);
+        LOOPBACK_CHECK(packet->length == sizeof(buffer) && ((uint32_t*)packet->data)[0] == buffer[0]);
+        LOOPBACK_CHECK(XLinkReleaseData(stream) == X_LINK_SUCCESS);
+    }
+    LOOPBACK_CHECK(XLinkCloseStream(stream) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(XLinkResetRemote(handler.linkId) == X_LINK_SUCCESS);
+    return 0;
+}
+
+}  // namespace
+
+int main() {
+    XLinkGlobalHandler_t gHandler = {};
+    LOOPBACK_CHECK(XLinkInitialize(&gHandler) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(XLinkSetSchedulerThreads(2) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(XLinkSetTcpReactorThreads(2) == X_LINK_SUCCESS);
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for(int link = 0; link < NUM_LINKS; link++) {
+        threads.emplace_back([&failures, link]() {
+            for(int round = 0; round < NUM_ROUNDS; round++) {
+                if(connectAndDisconnect(link) != 0) {
+                    failures++;
+                    return;
+                }
+            }
+        });
+    }
+    for(auto& thread : threads) thread.join();
+    LOOPBACK_CHECK(failures == 0);
+
+    // every link let go of the shared threads
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([]() { return XLinkSetSchedulerThreads(0) == X_LINK_SUCCESS; }));
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([]() { return XLinkSetTcpReactorThreads(0) == X_LINK_SUCCESS; }));
+
+    printf("loopback_pooled_links: OK\n");
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "loopback_peer.hpp"
+
+// Loopback test of XLinkGetStreamStats against an in-process fake device:
+// traffic counters, fill levels and the latency histograms after some roundtrips.
+
+namespace {
+
+uint64_t histogramCount(const uint32_t* histogram) {
+    uint64_t count = 0;
+    for(int bucket = 0; bucket < XLINK_STATS_LATENCY_BUCKETS; bucket++) count += histogram[bucket];
+    return count;
+}
+
+}  // namespace
+
+int main() {
+    XLinkGlobalHandler_t gHandler = {};
+    LOOPBACK_CHECK(XLinkInitialize(&gHandler) == X_LINK_SUCCESS);
+
+    // Bucket bounds grow with the index
+    LOOPBACK_CHECK(XLINK_STATS_BUCKET_LOWER_US(0) == 0);
+    for(int bucket = 1; bucket < XLINK_STATS_LATENCY_BUCKETS; bucket++) {
+        LOOPBACK_CHECK(XLINK_STATS_BUCKET_LOWER_US(bucket) > XLINK_STATS_BUCKET_LOWER_US(bucket - 1));
+    }
+
+    LoopbackPeer peer;
+    LOOPBACK_CHECK(peer.start());
+    std::string address = peer.address();
+    XLinkHandler_t handler = {};
+    handler.devicePath = &address[0];
+    handler.protocol = X_LINK_TCP_IP;
+    LOOPBACK_CHECK(XLinkConnect(&handler) == X_LINK_SUCCESS);
+
+    streamId_t stream = XLinkOpenStream(handler.linkId, "stats", 1024);
+    LOOPBACK_CHECK(stream != INVALID_STREAM_ID);
+
+    XLinkStreamStats_t stats;
+    LOOPBACK_CHECK(XLinkGetStreamStats(stream, &stats) == X_LINK_SUCCESS);
+    LOOPBACK_CHECK(stats.packetsOut == 0 && stats.packetsIn == 0);
+    LOOPBACK_CHECK(histogramCount(stats.callLatency) == 0);
+
+    constexpr int NUM_ROUNDTRIPS = 10;
+    constexpr int SIZE = 100;
+    uint8_t buffer[SIZE] = {0};
+    for(int i = 0; i < NUM_ROUNDTRIPS; i++) {
+        LOOPBACK_CHECK(XLinkWriteData(stream, buffer, SIZE) == X_LINK_SUCCESS);
+        streamPacketDesc_t* packet = nullptr;
+        LOOPBACK_CHECK(XLinkReadData(stream, &packet) == X_LINK_SUCCESS);
+        if(i == 0) {
+            // the packet is held until released
+            LOOPBACK_CHECK(XLinkGetStreamStats(stream, &stats) == X_LINK_SUCCESS);
+            LOOPBACK_CHECK(stats.localFillLevel == SIZE);
+        }
+        LOOPBACK_CHECK(XLinkReleaseData(stream) == X_LINK_SUCCESS);
+    }
+
+    // the device releases the last write asynchronously
+    LOOPBACK_CHECK(LoopbackPeer::waitUntil([&]() {
+        return XLinkGetStreamStats(stream, &stats) == X_LINK_SUCCESS && stats.remoteFillLevel == 0;
+    }));
+    LOOPBACK_CHECK(stats.packetsOut == NUM_ROUNDTRIPS);
+    LOOPBACK_CHECK(stats.bytesOut == NUM_ROUNDTRIPS * SIZE);
+    LOOPBACK_CHECK(stats.packetsIn == NUM_ROUNDTRIPS);
+    LOOPBACK_CHECK(stats.bytesIn == NUM_ROUNDTRIPS * SIZE);
+    LOOPBACK_CHECK(stats.drops == 0 && stats.nacks == 0);
+    LOOPBACK_CHECK(stats.localFillLevel == 0);
+    // every write and read call, and every received packet
+    LOOPBACK_CHECK(histogramCount(stats.callLatency) == 2 * NUM_ROUNDTRIPS);
+    LOOPBACK_CHECK(histogramCount(stats.transitLatency) == NUM_ROUNDTRIPS);
+
+    LOOPBACK_CHECK(XLinkGetStreamStats(stream, nullptr) != X_LINK_SUCCESS);
+    LOOPBACK_CHECK(XLinkCloseStream(stream) == X_LINK_SUCCESS);
+    XLinkResetRemote(handler.linkId);
+    printf("loopback_stream_stats: OK\n");
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "loopback_peer.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+// Loopback test of XLinkTraceDump against an in-process fake device: the dump is
+// Chrome trace event JSON holding the events and link writes of the roundtrips.
+
+int main() {
+    XLinkGlobalHandler_t gHandler = {};
+    LOOPBACK_CHECK(XLinkInitialize(&gHandler) == X_LINK_SUCCESS);
+
+    LoopbackPeer peer;
+    LOOPBACK_CHECK(peer.start());
+    std::string address = peer.address();
+    XLinkHandler_t handler = {};
+    handler.devicePath = &address[0];
+    handler.protocol = X_LINK_TCP_IP;
+    LOOPBACK_CHECK(XLinkConnect(&handler) == X_LINK_SUCCESS);
+
+    streamId_t stream = XLinkOpenStream(handler.linkId, "trace", 1024);
+    LOOPBACK_CHECK(stream != INVALID_STREAM_ID);
+    uint8_t buffer[64] = {0};
+    for(int i = 0; i < 4; i++) {
+        LOOPBACK_CHECK(XLinkWriteData(stream, buffer, sizeof(buffer)) == X_LINK_SUCCESS);
+        streamPacketDesc_t* packet = nullptr;
+        LOOPBACK_CHECK(XLinkReadData(stream, &packet) == X_LINK_SUCCESS);
+        LOOPBACK_CHECK(XLinkReleaseData(stream) == X_LINK_SUCCESS);
+    }
+
+    char path[] = "/tmp/xlink_loopback_traceXXXXXX";
+    int fd = mkstemp(path);
+    LOOPBACK_CHECK(fd >= 0);
+    close(fd);
+    XLinkError_t rc = XLinkTraceDump(handler.linkId, path);
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    unlink(path);
+    LOOPBACK_CHECK(rc == X_LINK_SUCCESS);
+
+    const std::string trace = content.str();
+    LOOPBACK_CHECK(trace.compare(0, 16, "{\"traceEvents\":[") == 0);
+    LOOPBACK_CHECK(trace.size() > 4 && trace.compare(trace.size() - 4, 4, "\n]}\n") == 0);
+    // event lifetimes of both origins, and the link writes
+    LOOPBACK_CHECK(trace.find("\"ph\":\"b\",\"cat\":\"local\",\"name\":\"XLINK_WRITE_REQ\"") != std::string::npos);
+    LOOPBACK_CHECK(trace.find("\"ph\":\"e\",\"cat\":\"remote\",\"name\":\"XLINK_WRITE_REQ\"") != std::string::npos);
+    LOOPBACK_CHECK(trace.find("\"ph\":\"X\",\"cat\":\"local\",\"name\":\"XLINK_WRITE_REQ\"") != std::string::npos);
+
+    LOOPBACK_CHECK(XLinkTraceDump(handler.linkId, "/nonexistent/dir/trace.json") != X_LINK_SUCCESS);
+
+    LOOPBACK_CHECK(XLinkCloseStream(stream) == X_LINK_SUCCESS);
+    XLinkResetRemote(handler.linkId);
+    printf("loopback_trace: OK\n");
+    return 0;
+}